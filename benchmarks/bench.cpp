@@ -0,0 +1,246 @@
+#include <brle.h>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+
+using namespace pg::brle;
+
+
+// The size of each generated data set of the corpus.
+static constexpr std::size_t corpus_size = 1 << 20;
+
+struct data_set
+{
+    std::string            name;
+    std::vector< uint8_t > data;
+};
+
+// The generators use the raw output of a fixed seeded std::mt19937_64, which is the same for every standard library,
+// so the corpus and the compression ratios are reproducible between builds and machines.
+static std::vector< uint8_t > filled( const uint8_t value )
+{
+    return std::vector< uint8_t >( corpus_size, value );
+}
+
+static std::vector< uint8_t > random_bytes()
+{
+    std::mt19937_64        rng( 1 );
+    std::vector< uint8_t > data( corpus_size );
+
+    for( auto & byte : data )
+    {
+        byte = static_cast< uint8_t >( rng() >> 56 );
+    }
+
+    return data;
+}
+
+// Sets each bit with the given probability.
+static std::vector< uint8_t > sparse( const double density )
+{
+    std::mt19937_64        rng( 2 );
+    std::vector< uint8_t > data( corpus_size );
+
+    for( auto & byte : data )
+    {
+        for( int bit = 0 ; bit < 8 ; ++bit )
+        {
+            const double sample = static_cast< double >( rng() >> 11 ) * 0x1.0p-53;
+            byte = static_cast< uint8_t >( byte | ( sample < density ) << bit );
+        }
+    }
+
+    return data;
+}
+
+// A monochrome image of 4096 pixels wide with filled rectangles and circles on a white background.
+static std::vector< uint8_t > bitmap()
+{
+    constexpr int width  = 4096;
+    constexpr int stride = width / 8;
+    constexpr int height = static_cast< int >( corpus_size / stride );
+
+    std::mt19937_64        rng( 3 );
+    std::vector< uint8_t > data( corpus_size, 0xFF );
+
+    const auto random = [ & ]( const int n ){ return static_cast< int >( rng() % static_cast< uint64_t >( n ) ); };
+    const auto black  = [ & ]( const int x, const int y ){ data[ y * stride + x / 8 ] &= static_cast< uint8_t >( ~( 1u << ( x % 8 ) ) ); };
+
+    for( int shape = 0 ; shape < 200 ; ++shape )
+    {
+        const int cx = random( width );
+        const int cy = random( height );
+        const int r  = 4 + random( 60 );
+
+        for( int y = std::max( cy - r, 0 ) ; y < std::min( cy + r, height ) ; ++y )
+        {
+            for( int x = std::max( cx - r, 0 ) ; x < std::min( cx + r, width ) ; ++x )
+            {
+                if( shape % 2 == 0 || ( x - cx ) * ( x - cx ) + ( y - cy ) * ( y - cy ) < r * r )
+                {
+                    black( x, y );
+                }
+            }
+        }
+    }
+
+    return data;
+}
+
+// Decodes the RLE file of the tests so that it can be encoded again.
+static bool load_rle( const char * const path, std::vector< uint8_t > & data )
+{
+    std::FILE * const file = std::fopen( path, "rb" );
+    if( file == nullptr )
+    {
+        return false;
+    }
+
+    std::vector< brle8 > rle;
+    for( int c = std::fgetc( file ) ; c != EOF ; c = std::fgetc( file ) )
+    {
+        rle.push_back( static_cast< brle8 >( c ) );
+    }
+    std::fclose( file );
+
+    data.resize( decoded_size( rle.data(), rle.data() + rle.size() ) );
+    decode( rle.data(), rle.data() + rle.size(), data.data() );
+
+    return true;
+}
+
+// Returns the median and minimum run time in nanoseconds.
+template< typename Function >
+static void measure( const int iterations, Function f, double & median, double & min )
+{
+    std::vector< double > times;
+    for( int i = 0 ; i < iterations ; ++i )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto stop  = std::chrono::steady_clock::now();
+
+        times.push_back( std::chrono::duration< double, std::nano >( stop - start ).count() );
+    }
+
+    std::sort( times.begin(), times.end() );
+
+    median = times[ times.size() / 2 ];
+    min    = times.front();
+}
+
+// Benchmarks encode, decode, encoder::push and decoder::pull on a data set as values of DataT.
+// Writes one JSON object to the standard output.
+template< typename DataT >
+static void benchmark( const data_set & set, const char * const type, const int iterations, const bool first )
+{
+    const auto count = set.data.size() / sizeof( DataT );
+    const auto bytes = count * sizeof( DataT );
+
+    std::vector< DataT > input( count );
+    std::vector< DataT > output( count );
+    std::memcpy( input.data(), set.data.data(), bytes );
+
+    const auto in_first = input.data();
+    const auto in_last  = in_first + count;
+
+    std::vector< brle8 > rle( encoded_size( in_first, in_last ) );
+
+    const auto rle_first = rle.data();
+    const auto rle_last  = encode( in_first, in_last, rle_first );
+
+    decode( rle_first, rle_last, output.data() );
+    const bool valid = output == input;
+
+    double encode_ns = 0.0, encode_min_ns = 0.0;
+    double decode_ns = 0.0, decode_min_ns = 0.0;
+    double push_ns   = 0.0, push_min_ns   = 0.0;
+    double pull_ns   = 0.0, pull_min_ns   = 0.0;
+
+    measure( iterations, [ & ](){ encode( in_first, in_last, rle_first ); }, encode_ns, encode_min_ns );
+    measure( iterations, [ & ](){ decode( rle_first, rle_last, output.data() ); }, decode_ns, decode_min_ns );
+
+    measure( iterations, [ & ]()
+    {
+        encoder< DataT, brle8 * > e( rle_first );
+        for( auto it = in_first ; it != in_last ; ++it )
+        {
+            e.push( *it );
+        }
+        e.flush();
+    }, push_ns, push_min_ns );
+
+    measure( iterations, [ & ]()
+    {
+        decoder< DataT, const brle8 * > d( rle_first, rle_last );
+
+        auto out = output.data();
+        for( auto result = d.pull() ; result ; result = d.pull() )
+        {
+            *out++ = result.data;
+        }
+    }, pull_ns, pull_min_ns );
+
+    const auto mbps = [ bytes ]( const double ns ){ return static_cast< double >( bytes ) * 1000.0 / ns; };
+
+    std::printf( "%s    {\"data\": \"%s\", \"type\": \"%s\", \"bytes\": %zu, \"rle_bytes\": %zu, \"valid\": %s,\n"
+                 "     \"encode_ns\": %.0f, \"encode_min_ns\": %.0f, \"encode_mbps\": %.1f,\n"
+                 "     \"decode_ns\": %.0f, \"decode_min_ns\": %.0f, \"decode_mbps\": %.1f,\n"
+                 "     \"push_ns\": %.0f, \"push_min_ns\": %.0f, \"push_mbps\": %.1f,\n"
+                 "     \"pull_ns\": %.0f, \"pull_min_ns\": %.0f, \"pull_mbps\": %.1f}",
+                 first ? "" : ",\n", set.name.c_str(), type, bytes, static_cast< std::size_t >( rle_last - rle_first ), valid ? "true" : "false",
+                 encode_ns, encode_min_ns, mbps( encode_ns ),
+                 decode_ns, decode_min_ns, mbps( decode_ns ),
+                 push_ns, push_min_ns, mbps( push_ns ),
+                 pull_ns, pull_min_ns, mbps( pull_ns ) );
+}
+
+// Usage: bench [rle_file [iterations]]
+// The times are the median and the minimum of the iterations.
+int main( const int argc, const char * argv[] )
+{
+    const char * const rle_path   = argc > 1 ? argv[ 1 ] : "../tests/test.bmp.rle";
+    const int          iterations = argc > 2 ? std::max( std::atoi( argv[ 2 ] ), 1 ) : 10;
+
+    std::vector< data_set > corpus;
+    corpus.push_back( { "zeros", filled( 0x00 ) } );
+    corpus.push_back( { "ones", filled( 0xFF ) } );
+    corpus.push_back( { "random", random_bytes() } );
+    corpus.push_back( { "sparse_0.1", sparse( 0.001 ) } );
+    corpus.push_back( { "sparse_1", sparse( 0.01 ) } );
+    corpus.push_back( { "sparse_10", sparse( 0.1 ) } );
+    corpus.push_back( { "alternating", filled( 0x55 ) } );
+    corpus.push_back( { "bitmap", bitmap() } );
+
+    data_set test_bmp = { "test_bmp", {} };
+    if( !load_rle( rle_path, test_bmp.data ) )
+    {
+        std::fprintf( stderr, "Cannot read '%s', it is left out of the corpus.\n", rle_path );
+    }
+    else
+    {
+        corpus.push_back( std::move( test_bmp ) );
+    }
+
+    std::printf( "{\"iterations\": %d, \"results\": [\n", iterations );
+
+    bool first = true;
+    for( const auto & set : corpus )
+    {
+        benchmark< uint8_t >( set, "uint8_t", iterations, first );
+        benchmark< uint16_t >( set, "uint16_t", iterations, false );
+        benchmark< uint32_t >( set, "uint32_t", iterations, false );
+        benchmark< uint64_t >( set, "uint64_t", iterations, false );
+        first = false;
+    }
+
+    std::printf( "\n]}\n" );
+
+    return 0;
+}
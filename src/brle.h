@@ -23,6 +23,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 #include <cassert>
 #include <algorithm>
 #include <limits>
@@ -69,11 +70,22 @@ static constexpr brle8 brle8_mode( brle8 rle )
     return rle & 0xC0;
 }
 
+static constexpr bool is_literal( brle8 rle )
+{
+    return ( rle & 0x80 ) == mode::literal;
+}
+
 static constexpr int count( const brle8 rle )
 {
     return ( rle & 0x3F ) + min_brle_len;
 }
 
+// Returns the number of bits that are produced by a block, which includes the stuffed bit of a zeros or ones block.
+static constexpr int block_size( const brle8 rle )
+{
+    return is_literal( rle ) ? literal_size : count( rle ) + ( count( rle ) != max_count );
+}
+
 template< typename T >
 static constexpr brle8 make_literal( T buffer )
 {
@@ -92,6 +104,81 @@ static constexpr brle8 make_ones( int count )
     return static_cast< brle8 >( mode::ones | ( count - min_brle_len ) );
 }
 
+template< typename T >
+static constexpr T low_mask( int bits )
+{
+    assert( bits >= 0 && bits <= std::numeric_limits< T >::digits );
+    return bits ? static_cast< T >( std::numeric_limits< T >::max() >> ( std::numeric_limits< T >::digits - bits ) ) : T();
+}
+
+//
+// Returns the number of successive elements from 'first' that are equal to 'value'.
+// The first few elements are compared one at a time because most runs in dense data are short.
+// When they all match, the elements are compared a cache line at a time so that long sequences of zeros or ones
+// are skipped quickly. The comparisons in a block are folded into one value without early exits, which lets
+// optimizing compilers vectorize the inner loop with the SIMD instructions that are available for the target.
+//
+
+template< typename T >
+static constexpr std::ptrdiff_t uniform_length( const T * const first, const T * const last, const T value )
+{
+    constexpr std::ptrdiff_t block_size = 64;
+    constexpr std::ptrdiff_t stride     = sizeof( T ) < block_size ? block_size / static_cast< std::ptrdiff_t >( sizeof( T ) ) : 1;
+    constexpr std::ptrdiff_t prefix     = 8;
+
+    auto it = first;
+    for( const auto prefix_last = last - first > prefix ? first + prefix : last ; it != prefix_last ; ++it )
+    {
+        if( *it != value )
+        {
+            return it - first;
+        }
+    }
+    while( last - it >= stride )
+    {
+        T diff = {};
+        for( std::ptrdiff_t i = 0 ; i < stride ; ++i )
+        {
+            diff = diff | static_cast< T >( it[ i ] ^ value );
+        }
+        if( diff )
+        {
+            break;
+        }
+        it = it + stride;
+    }
+    while( it != last && *it == value )
+    {
+        ++it;
+    }
+
+    return it - first;
+}
+
+//
+// Portable equivalents of the PDEP and PEXT instructions with a mask of 0x7F7F7F7F7F7F7F7F.
+// 'deposit_literals' spreads 8 successive groups of 7 bits into the lower 7 bits of each byte while
+// 'extract_literals' packs the lower 7 bits of each byte into 56 successive bits.
+//
+
+static constexpr uint64_t deposit_literals( uint64_t bits )
+{
+    bits = ( bits & 0x000000000FFFFFFFu ) | ( ( bits & 0x00FFFFFFF0000000u ) << 4 );
+    bits = ( bits & 0x00003FFF00003FFFu ) | ( ( bits & 0x0FFFC0000FFFC000u ) << 2 );
+    bits = ( bits & 0x007F007F007F007Fu ) | ( ( bits & 0x3F803F803F803F80u ) << 1 );
+
+    return bits;
+}
+
+static constexpr uint64_t extract_literals( uint64_t bytes )
+{
+    bytes = ( bytes & 0x007F007F007F007Fu ) | ( ( bytes & 0x7F007F007F007F00u ) >> 1 );
+    bytes = ( bytes & 0x00003FFF00003FFFu ) | ( ( bytes & 0x3FFF00003FFF0000u ) >> 2 );
+    bytes = ( bytes & 0x000000000FFFFFFFu ) | ( ( bytes & 0x0FFFFFFF00000000u ) >> 4 );
+
+    return bytes;
+}
+
 #if defined( __cpp_lib_bitops )
 
 //
@@ -110,6 +197,12 @@ constexpr auto countr_one( T && val ) -> decltype( auto )
     return std::countr_one( std::forward< T >( val ) );
 }
 
+template< typename T >
+constexpr auto popcount( T && val ) -> decltype( auto )
+{
+    return std::popcount( std::forward< T >( val ) );
+}
+
 #else
 
 //
@@ -207,8 +300,68 @@ constexpr int countr_one( T value )
     return countr_zero( static_cast< T >( ~value ) );
 }
 
+//
+// Surrogate for std::popcount when NOT compiling with C++20.
+//
+// Inspired by:
+//   https://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
+//
+
+template< typename T >
+constexpr int popcount( const T value )
+{
+    static_assert( std::is_unsigned< T >::value, "expected an unsigned value" );
+
+    uint64_t bits = value;
+
+    bits = bits - ( ( bits >> 1 ) & 0x5555555555555555u );
+    bits = ( bits & 0x3333333333333333u ) + ( ( bits >> 2 ) & 0x3333333333333333u );
+    bits = ( bits + ( bits >> 4 ) ) & 0x0F0F0F0F0F0F0F0Fu;
+
+    return static_cast< int >( ( bits * 0x0101010101010101u ) >> 56 );
+}
+
 #endif
 
+struct literals
+{
+    uint64_t bits  = {};
+    int      count = {};
+};
+
+//
+// Reads up to 'max' successive literal blocks at once and returns their data packed together.
+// This requires to look ahead in the input and is only done for raw pointers.
+//
+
+template< typename InputIt >
+constexpr literals read_literals( InputIt &, InputIt, int )
+{
+    return {};
+}
+
+template< typename T >
+constexpr literals read_literals( T * & input, T * const last, int max )
+{
+    if( max <= 0 || last - input < 8 )
+    {
+        return {};
+    }
+
+    uint64_t bytes = {};
+    for( int i = 0 ; i < 8 ; ++i )
+    {
+        bytes = bytes | static_cast< uint64_t >( input[ i ] ) << ( 8 * i );
+    }
+
+    const uint64_t non_literals = bytes & 0x8080808080808080u;
+    const int      count        = std::min( non_literals ? countr_zero( non_literals ) / 8 : 8, max );
+
+    input = input + count;
+
+    return { extract_literals( bytes ) & low_mask< uint64_t >( count * literal_size ), count };
+}
+
 }
 
 template< typename DataT, typename OutputIt >
@@ -314,6 +467,104 @@ class encoder
         }
     }
 
+    // Emits up to 8 literal blocks at once when none of the literal positions in the next 57 bits starts a
+    // sequence of 8 or more zeros or ones. Returns the number of literal blocks that were emitted.
+    constexpr int push_literals( const DataT * & first, const DataT * const last )
+    {
+        constexpr auto buffer_capacity = std::numeric_limits< DataT >::digits;
+        constexpr auto window_size     = 8 * detail::literal_size + 1;
+
+        if( buffer_capacity > std::numeric_limits< uint64_t >::digits )
+        {
+            return 0;
+        }
+
+        // The buffer holds less bits than a value, so a fixed number of values always fills the window.
+        constexpr auto window_values = ( window_size + buffer_capacity - 1 ) / buffer_capacity;
+
+        if( last - first < window_values )
+        {
+            return 0;
+        }
+
+        // Most attempts fail on the first literal position, which is tested before the rest of the window is built.
+        uint64_t window = buffer | static_cast< uint64_t >( first[ 0 ] ) << buffer_size;
+        if( ( window & 0xFF ) == 0 || ( window & 0xFF ) == 0xFF )
+        {
+            return 0;
+        }
+
+        for( int i = 1 ; i < window_values ; ++i )
+        {
+            window = window | static_cast< uint64_t >( first[ i ] ) << ( buffer_size + i * buffer_capacity );
+        }
+
+        // A literal position starts a sequence of 8 equal bits when its 7 following transitions are all zero.
+        const auto transitions = detail::deposit_literals( window ^ ( window >> 1 ) );
+        const auto sequences   = ( transitions - 0x0101010101010101u ) & ~transitions & 0x8080808080808080u;
+        const auto count       = sequences ? detail::countr_zero( sequences ) / 8 : 8;
+
+        if( count == 0 )
+        {
+            return 0;
+        }
+
+        const auto data = detail::deposit_literals( window );
+        for( int i = 0 ; i < count ; ++i )
+        {
+            *output++ = detail::make_literal( data >> ( 8 * i ) );
+        }
+
+        const auto consumed = count * detail::literal_size;
+        if( consumed <= buffer_size )
+        {
+            buffer      = buffer >> consumed;
+            buffer_size = buffer_size - consumed;
+        }
+        else
+        {
+            const auto values    = ( consumed - buffer_size + buffer_capacity - 1 ) / buffer_capacity;
+            const auto remaining = buffer_size + values * buffer_capacity - consumed;
+
+            first       = first + values;
+            buffer      = remaining ? static_cast< DataT >( first[ -1 ] >> ( buffer_capacity - remaining ) ) : DataT();
+            buffer_size = remaining;
+        }
+
+        return count;
+    }
+
+    // Extends the current zeros or ones run with 'bits' bits of the same value.
+    // The pending bits in the buffer must be part of that run.
+    constexpr void extend_run( const uint64_t bits )
+    {
+        assert( state != encode_state::init );
+
+        const auto run       = static_cast< uint64_t >( rlen ) + static_cast< uint64_t >( buffer_size ) + bits;
+        const auto remainder = static_cast< int >( run % detail::max_count );
+        const auto max_block = state == encode_state::zeros ? detail::make_zeros( detail::max_count )
+                                                            : detail::make_ones( detail::max_count );
+
+        for( auto blocks = run / detail::max_count ; blocks > 0 ; --blocks )
+        {
+            *output++ = max_block;
+        }
+
+        if( remainder > detail::literal_size )
+        {
+            buffer      = {};
+            buffer_size = {};
+            rlen        = remainder;
+        }
+        else
+        {
+            buffer      = state == encode_state::zeros ? DataT() : detail::low_mask< DataT >( remainder );
+            buffer_size = remainder;
+            state       = encode_state::init;
+            rlen        = {};
+        }
+    }
+
 public:
     constexpr encoder() = default;
 
@@ -364,7 +615,8 @@ public:
 
             assert( consumed > 0 );
 
-            shift_buffer = shift_buffer >> static_cast< DataT >( consumed );
+            // Shifting by the full width of a type is undefined; the whole buffer is consumed in that case.
+            shift_buffer = consumed < buffer_capacity ? shift_buffer >> static_cast< DataT >( consumed ) : DataT();
             bits         = bits - consumed;
         }
         while( ( bits + buffer_capacity ) >= buffer_capacity );
@@ -373,10 +625,14 @@ public:
         {
             buffer = shift_buffer | data << static_cast< DataT >( bits );
         }
-        else
+        else if( -bits < buffer_capacity )
         {
             buffer = data >> static_cast< DataT >( -bits );
         }
+        else
+        {
+            buffer = {};
+        }
         buffer_size = bits + buffer_capacity;
 
         assert( buffer_size >= 0 );
@@ -384,6 +640,108 @@ public:
         return output;
     }
 
+    // Pushes a contiguous range of data.
+    // Sequences of zeros or ones that continue the current run are consumed in bulk instead of one value at a time
+    // and data without such sequences is written as bursts of literal blocks.
+    constexpr OutputIt push( const DataT * first, const DataT * const last )
+    {
+        constexpr auto buffer_capacity = std::numeric_limits< DataT >::digits;
+        constexpr auto all_ones        = std::numeric_limits< DataT >::max();
+
+        // Values are pushed in batches between the attempts to emit a burst of literals. A batch doubles in size
+        // each time a burst is cut short so that sparse data is not scanned for literals at every value.
+        constexpr std::ptrdiff_t min_batch = 4;
+        constexpr std::ptrdiff_t max_batch = 32;
+
+        auto batch = min_batch;
+
+        while( first != last )
+        {
+            if( state == encode_state::init && push_literals( first, last ) == 8 )
+            {
+                batch = min_batch;
+                continue;
+            }
+
+            for( const auto end = last - first > batch ? first + batch : last ; first < end ; )
+            {
+                const auto data = *first;
+
+                if( ( state == encode_state::zeros && data == DataT() && buffer == DataT() ) ||
+                    ( state == encode_state::ones && data == all_ones && buffer == detail::low_mask< DataT >( buffer_size ) ) )
+                {
+                    const auto n = detail::uniform_length( first, last, data );
+
+                    extend_run( static_cast< uint64_t >( n ) * buffer_capacity );
+                    first = first + n;
+                }
+                else
+                {
+                    push( data );
+                    ++first;
+                }
+            }
+            batch = std::min( batch * 2, max_batch );
+        }
+
+        return output;
+    }
+
+    // Pushes the lower 'nbits' bits of 'value'.
+    // The encoder collects the bits until they complete a whole value of DataT.
+    constexpr OutputIt push_bits( DataT value, int nbits )
+    {
+        constexpr auto buffer_capacity = std::numeric_limits< DataT >::digits;
+
+        assert( nbits >= 0 && nbits <= buffer_capacity );
+
+        value = value & detail::low_mask< DataT >( nbits );
+
+        while( buffer_size + nbits >= buffer_capacity )
+        {
+            const auto fill = buffer_capacity - buffer_size;
+            const auto data = static_cast< DataT >( buffer | value << static_cast< DataT >( buffer_size ) );
+
+            value       = fill < buffer_capacity ? static_cast< DataT >( value >> static_cast< DataT >( fill ) ) : DataT();
+            nbits       = nbits - fill;
+            buffer      = {};
+            buffer_size = {};
+
+            push( data );
+        }
+
+        buffer      = static_cast< DataT >( buffer | value << static_cast< DataT >( buffer_size ) );
+        buffer_size = buffer_size + nbits;
+
+        return output;
+    }
+
+    // Pushes 'count' bits that are all equal to 'bit'.
+    // Once the encoder is in a run of the same bits the whole count is added at once.
+    constexpr OutputIt push_run( const bool bit, uint64_t count )
+    {
+        constexpr auto buffer_capacity = std::numeric_limits< DataT >::digits;
+
+        const auto value = bit ? std::numeric_limits< DataT >::max() : DataT();
+
+        while( count > 0 )
+        {
+            if( ( state == encode_state::zeros && !bit && buffer == DataT() ) ||
+                ( state == encode_state::ones && bit && buffer == detail::low_mask< DataT >( buffer_size ) ) )
+            {
+                extend_run( count );
+                break;
+            }
+
+            const auto nbits = static_cast< int >( std::min( count, static_cast< uint64_t >( buffer_capacity ) ) );
+
+            push_bits( value, nbits );
+            count = count - static_cast< uint64_t >( nbits );
+        }
+
+        return output;
+    }
+
     constexpr OutputIt flush()
     {
         while( buffer_size >= detail::literal_size ||
@@ -425,84 +783,213 @@ public:
     }
 };
 
-template< typename InputIt, typename OutputIt >
-constexpr auto encode( InputIt input, InputIt last, OutputIt output ) -> OutputIt
+namespace detail
 {
-    using DataT = typename std::iterator_traits< InputIt >::value_type;
-
-    encoder< DataT, OutputIt > e( output );
 
+template< typename Encoder, typename InputIt >
+constexpr void push( Encoder & e, InputIt input, InputIt last )
+{
     while( input != last )
     {
         e.push( *input++ );
     }
-
-    return e.flush();
 }
 
-enum decoder_status
+template< typename Encoder, typename T >
+constexpr void push( Encoder & e, T * input, T * last )
 {
-    success,        ///< Decoded successfuly; value is valid
-    done,           ///< No more data available to decode
-};
+    e.push( input, last );
+}
 
-template< typename DataT >
-struct decoder_result
+template< typename Encoder, typename InputIt >
+constexpr InputIt push_n( Encoder & e, InputIt input, InputIt last, std::ptrdiff_t n )
 {
-    static_assert( std::is_unsigned< DataT >::value, "expected an unsigned data type" );
-
-    DataT          data   = {};
-    decoder_status status = decoder_status::done;
-
-    constexpr operator bool() const
+    for( ; n > 0 && input != last ; --n )
     {
-        return status == decoder_status::success;
+        e.push( *input++ );
     }
-};
 
-template< typename DataT, typename InputIt >
-class decoder
+    return input;
+}
+
+template< typename Encoder, typename T >
+constexpr T * push_n( Encoder & e, T * input, T * last, std::ptrdiff_t n )
 {
-    static_assert( std::is_unsigned< DataT >::value, "expected an unsigned data type" );
-    static_assert( std::is_same< typename std::iterator_traits< InputIt >::value_type, brle8 >::value,
-                   "expected an input iterator that returns brle8 like type when dereferenced" );
+    const auto end = last - input > n ? input + n : last;
 
-    enum class decode_state
-    {
-        read,
-        zeros,
-        zeros_max,
-        ones,
-        ones_max
-    };
+    e.push( input, end );
 
-    InputIt      input       = {};
-    InputIt      last        = {};
-    DataT        buffer      = {};
-    int          buffer_size = {};
-    decode_state state       = decode_state::read;
-    int          rlen        = {};
+    return end;
+}
 
-public:
-    constexpr decoder() = default;
+// Upper bound of the number of blocks that the encoder writes when 'bits' bits are pushed.
+// Besides the blocks for the pushed bits one block may be written for a run that was started earlier.
+static constexpr std::ptrdiff_t max_blocks( std::ptrdiff_t bits )
+{
+    return 2 + bits / literal_size;
+}
 
-    constexpr decoder( InputIt input, InputIt last )
-        : input( input )
-        , last( last )
-    {}
+}
 
-    constexpr decoder( decoder && other )
-        : input( std::move( other.input ) )
-        , last( std::move( other.last ) )
-        , buffer( other.buffer )
-        , buffer_size( other.buffer_size )
-        , state( other.state )
-        , rlen( other.rlen )
-    {}
+template< typename InputIt, typename OutputIt >
+constexpr auto encode( InputIt input, InputIt last, OutputIt output ) -> OutputIt;
 
-    constexpr void set_input( InputIt input_, InputIt last_ )
-    {
-        input = input_;
+namespace detail
+{
+
+// Output iterator that only counts the values that are written to it.
+struct counting_iterator
+{
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = void;
+    using pointer           = void;
+    using reference         = void;
+    using iterator_category = std::output_iterator_tag;
+
+    std::size_t count = {};
+
+    constexpr counting_iterator & operator=( brle8 )  { return *this; }
+    constexpr counting_iterator & operator*()         { return *this; }
+    constexpr counting_iterator & operator++()        { ++count; return *this; }
+    constexpr counting_iterator   operator++( int )   { auto it = *this; ++count; return it; }
+};
+
+}
+
+template< typename InputIt >
+constexpr auto encoded_size( InputIt input, InputIt last ) -> std::size_t
+{
+    return encode( input, last, detail::counting_iterator() ).count;
+}
+
+template< typename InputIt, typename OutputIt >
+constexpr auto encode( InputIt input, InputIt last, OutputIt output ) -> OutputIt
+{
+    using DataT = typename std::iterator_traits< InputIt >::value_type;
+
+    encoder< DataT, OutputIt > e( output );
+
+    detail::push( e, input, last );
+
+    return e.flush();
+}
+
+template< typename DataT, typename OutputIt, typename InputIt >
+constexpr auto encode_some( encoder< DataT, OutputIt > & e, InputIt input, InputIt last, OutputIt output_last ) -> InputIt
+{
+    constexpr auto digits = std::numeric_limits< DataT >::digits;
+
+    while( input != last )
+    {
+        // Push only the number of values for which the blocks fit in the remaining output, including the pending bits.
+        const std::ptrdiff_t space  = output_last - e.get_output();
+        const std::ptrdiff_t values = ( ( space - detail::max_blocks( 0 ) + 1 ) * detail::literal_size - digits ) / digits;
+
+        if( values <= 0 )
+        {
+            break;
+        }
+
+        input = detail::push_n( e, input, last, values );
+    }
+
+    return input;
+}
+
+// Position in the RLE data from which decoding can start.
+struct checkpoint
+{
+    std::size_t input_offset = {};   ///< Offset of the block in the RLE data
+    uint64_t    bit_offset   = {};   ///< Offset of the first bit that is produced by that block
+};
+
+template< typename InputIt, typename OutputIt >
+constexpr auto build_index( InputIt input, InputIt last, uint64_t interval, OutputIt output ) -> OutputIt
+{
+    assert( interval > 0 );
+
+    std::size_t offset = {};
+    uint64_t    bits   = {};
+    uint64_t    next   = {};
+
+    // Records the block that contains the bit at each multiple of the interval.
+    for( ; input != last ; ++offset )
+    {
+        const auto end = bits + static_cast< uint64_t >( detail::block_size( *input++ ) );
+        if( next < end )
+        {
+            *output++ = checkpoint{ offset, bits };
+            next      = next + ( ( end - next + interval - 1 ) / interval ) * interval;
+        }
+        bits = end;
+    }
+
+    return output;
+}
+
+enum decoder_status
+{
+    success,        ///< Decoded successfuly; value is valid
+    done,           ///< No more data available to decode
+};
+
+template< typename DataT >
+struct decoder_result
+{
+    static_assert( std::is_unsigned< DataT >::value, "expected an unsigned data type" );
+
+    DataT          data   = {};
+    decoder_status status = decoder_status::done;
+
+    constexpr operator bool() const
+    {
+        return status == decoder_status::success;
+    }
+};
+
+template< typename DataT, typename InputIt >
+class decoder
+{
+    static_assert( std::is_unsigned< DataT >::value, "expected an unsigned data type" );
+    static_assert( std::is_same< typename std::iterator_traits< InputIt >::value_type, brle8 >::value,
+                   "expected an input iterator that returns brle8 like type when dereferenced" );
+
+    enum class decode_state
+    {
+        read,
+        zeros,
+        zeros_max,
+        ones,
+        ones_max
+    };
+
+    InputIt      input       = {};
+    InputIt      last        = {};
+    DataT        buffer      = {};
+    int          buffer_size = {};
+    decode_state state       = decode_state::read;
+    int          rlen        = {};
+
+public:
+    constexpr decoder() = default;
+
+    constexpr decoder( InputIt input, InputIt last )
+        : input( input )
+        , last( last )
+    {}
+
+    constexpr decoder( decoder && other )
+        : input( std::move( other.input ) )
+        , last( std::move( other.last ) )
+        , buffer( other.buffer )
+        , buffer_size( other.buffer_size )
+        , state( other.state )
+        , rlen( other.rlen )
+    {}
+
+    constexpr void set_input( InputIt input_, InputIt last_ )
+    {
+        input = input_;
         last  = last_;
     }
 
@@ -511,6 +998,73 @@ public:
         return input;
     }
 
+    // Positions the decoder so that the next pulled value starts with the bit at 'bit_offset'.
+    // 'first' is the start of the RLE data and must be a random access iterator.
+    // Decoding starts from the last checkpoint in the index before 'bit_offset'; an empty index starts from 'first'.
+    // Returns false when the RLE data ends before 'bit_offset'.
+    template< typename CheckpointIt >
+    constexpr bool seek( InputIt first, CheckpointIt index_first, CheckpointIt index_last, uint64_t bit_offset )
+    {
+        checkpoint start;
+        while( index_first != index_last )
+        {
+            const auto half = ( index_last - index_first ) / 2;
+            const auto mid  = index_first + half;
+            if( mid->bit_offset <= bit_offset )
+            {
+                start       = *mid;
+                index_first = mid + 1;
+            }
+            else
+            {
+                index_last = mid;
+            }
+        }
+
+        input       = first + static_cast< typename std::iterator_traits< InputIt >::difference_type >( start.input_offset );
+        buffer      = {};
+        buffer_size = {};
+        state       = decode_state::read;
+        rlen        = {};
+
+        // Skip whole blocks and continue with the remainder of the block that contains the bit.
+        auto skip = bit_offset - start.bit_offset;
+        while( skip > 0 )
+        {
+            if( input == last )
+            {
+                return false;
+            }
+
+            const auto in   = *input++;
+            const auto size = static_cast< uint64_t >( detail::block_size( in ) );
+            if( skip >= size )
+            {
+                skip = skip - size;
+                continue;
+            }
+
+            const auto skipped = static_cast< int >( skip );
+            if( detail::is_literal( in ) )
+            {
+                buffer      = static_cast< DataT >( ( in & 0x7F ) >> skipped );
+                buffer_size = detail::literal_size - skipped;
+            }
+            else
+            {
+                const auto count = detail::count( in );
+                const auto ones  = detail::brle8_mode( in ) == detail::mode::ones;
+
+                rlen  = count - skipped;
+                state = count < detail::max_count ? ( ones ? decode_state::ones : decode_state::zeros )
+                                                  : ( ones ? decode_state::ones_max : decode_state::zeros_max );
+            }
+            break;
+        }
+
+        return true;
+    }
+
     constexpr decoder_result< DataT > pull()
     {
         constexpr auto buffer_capacity = std::numeric_limits< DataT >::digits;
@@ -532,16 +1086,23 @@ public:
                     {
                     default:
                     {
-                        buffer = buffer | static_cast< DataT >( in ) << static_cast< DataT >( buffer_size );
+                        // Append the literal blocks that follow as well as long as they fit in the buffer.
+                        const auto more = buffer_capacity >= 2 * detail::literal_size
+                                        ? detail::read_literals( input, last, ( buffer_capacity - buffer_size ) / detail::literal_size - 1 )
+                                        : detail::literals();
+                        const auto bits = static_cast< uint64_t >( in ) | more.bits << detail::literal_size;
+                        const auto size = ( more.count + 1 ) * detail::literal_size;
+
+                        buffer = buffer | static_cast< DataT >( bits ) << static_cast< DataT >( buffer_size );
 
-                        const auto produced = buffer_size + detail::literal_size;
+                        const auto produced = buffer_size + size;
                         if( produced >= buffer_capacity )
                         {
                             const auto data = buffer;
                             const auto shift = buffer_capacity - buffer_size;
 
-                            buffer      = static_cast< DataT >( in ) >> static_cast< DataT >( shift );
-                            buffer_size = detail::literal_size - shift;
+                            buffer      = static_cast< DataT >( bits >> shift );
+                            buffer_size = size - shift;
 
                             return { data, decoder_status::success };
                         }
@@ -686,10 +1247,198 @@ public:
     }
 };
 
-template< typename InputIt, typename OutputIt, typename OutputValueT = typename std::iterator_traits< OutputIt >::value_type >
-constexpr auto decode( InputIt input, InputIt last, OutputIt output ) -> OutputIt
+namespace detail
+{
+
+//
+// The bits that are produced by a block.
+// 'low' holds the first 64 bits and 'high' the bits that remain for runs that are longer than 64 bits.
+//
+
+struct block_bits
+{
+    uint64_t low  = {};
+    uint8_t  high = {};
+    uint8_t  size = {};
+};
+
+static constexpr block_bits make_block_bits( const brle8 rle )
+{
+    block_bits bits;
+
+    if( is_literal( rle ) )
+    {
+        bits.low  = rle;
+        bits.size = literal_size;
+
+        return bits;
+    }
+
+    const auto n    = count( rle );
+    const auto ones = brle8_mode( rle ) == mode::ones;
+
+    // The sequence of n zeros or ones followed by the stuffed bit when the count is less than the maximum.
+    bits.low  = ones ? ( n < 64 ? low_mask< uint64_t >( n ) : ~uint64_t() ) : ( n < 64 ? uint64_t( 1 ) << n : 0 );
+    bits.high = ones ? ( n > 64 ? low_mask< uint8_t >( n - 64 ) : 0 ) : ( n >= 64 && n < max_count ? uint8_t( 1u << ( n - 64 ) ) : 0 );
+    bits.size = static_cast< uint8_t >( block_size( rle ) );
+
+    if( !ones && n == max_count )
+    {
+        bits.low = 0;
+    }
+
+    return bits;
+}
+
+struct block_table
+{
+    block_bits blocks[ 256 ];
+
+    constexpr block_table()
+        : blocks()
+    {
+        for( int i = 0 ; i < 256 ; ++i )
+        {
+            blocks[ i ] = make_block_bits( static_cast< brle8 >( i ) );
+        }
+    }
+};
+
+template< typename T = void >
+struct tables
+{
+    static constexpr block_table decode = block_table();
+};
+
+template< typename T >
+constexpr block_table tables< T >::decode;
+
+//
+// Returns the number of blocks that follow and are equal to 'rle'.
+// Counting requires to look ahead in the input and is only done for raw pointers.
+//
+
+template< typename InputIt >
+constexpr std::ptrdiff_t skip_blocks( InputIt &, InputIt, brle8 )
+{
+    return 0;
+}
+
+template< typename T >
+constexpr std::ptrdiff_t skip_blocks( T * & input, T * const last, const brle8 rle )
+{
+    const auto n = uniform_length( input, last, static_cast< T >( rle ) );
+
+    input = input + n;
+
+    return n;
+}
+
+template< typename DataT, typename OutputIt >
+constexpr void fill( OutputIt & output, uint64_t count, const DataT value )
+{
+    // Compilers turn this loop into a memset or vector stores when the output is a raw pointer.
+    for( ; count > 0 ; --count )
+    {
+        *output++ = value;
+    }
+}
+
+template< typename DataT, typename OutputIt >
+constexpr void write_bits( OutputIt & output, const uint64_t bits, const int size )
+{
+    constexpr auto digits = std::numeric_limits< DataT >::digits;
+
+    for( int i = 0 ; i + digits <= size ; i = i + digits )
+    {
+        *output++ = static_cast< DataT >( bits >> i );
+    }
+}
+
+//
+// Decoder that looks up the bits for each block in a table and collects them in a 64-bit accumulator.
+// The accumulator is written to the output as soon as it is full.
+// The bits in the accumulator that do not fill a whole word at the end are left in 'word' and 'size'.
+//
+
+template< typename DataT, typename InputIt, typename OutputIt >
+constexpr void decode_blocks( InputIt input, const InputIt last, OutputIt & output, uint64_t & word, int & size )
+{
+    constexpr auto word_size = std::numeric_limits< uint64_t >::digits;
+
+    while( input != last )
+    {
+        const brle8 rle  = *input++;
+        auto        bits = tables<>::decode.blocks[ rle ];
+
+        // Successive blocks of the maximum count are written as whole words instead of block by block.
+        if( ( rle == make_zeros( max_count ) || rle == make_ones( max_count ) ) && input != last && *input == rle )
+        {
+            const auto blocks = 1 + skip_blocks( input, last, rle );
+            const auto fill   = rle == make_zeros( max_count ) ? uint64_t() : ~uint64_t();
+            auto       run    = static_cast< uint64_t >( blocks ) * max_count - static_cast< uint64_t >( word_size - size );
+
+            write_bits< DataT >( output, word | fill << size, word_size );
+            detail::fill( output, ( run / word_size ) * ( word_size / std::numeric_limits< DataT >::digits ), static_cast< DataT >( fill ) );
+
+            run  = run % word_size;
+            word = fill & low_mask< uint64_t >( static_cast< int >( run ) );
+            size = static_cast< int >( run );
+            continue;
+        }
+
+        if( is_literal( rle ) )
+        {
+            const auto more = read_literals( input, last, 7 );
+
+            bits.low  = bits.low | more.bits << literal_size;
+            bits.size = static_cast< uint8_t >( bits.size + more.count * literal_size );
+        }
+
+        const auto start = size;
+
+        word = word | bits.low << start;
+        size = start + bits.size;
+        if( size < word_size )
+        {
+            continue;
+        }
+
+        // The bits of a block can span up to three words.
+        write_bits< DataT >( output, word, word_size );
+        word = ( ( bits.low >> 1 ) >> ( word_size - 1 - start ) ) | static_cast< uint64_t >( bits.high ) << start;
+        size = size - word_size;
+        if( size >= word_size )
+        {
+            write_bits< DataT >( output, word, word_size );
+            word = ( static_cast< uint64_t >( bits.high ) >> 1 ) >> ( word_size - 1 - start );
+            size = size - word_size;
+        }
+    }
+}
+
+template< typename DataT, typename InputIt, typename OutputIt >
+constexpr OutputIt decode_blocks( InputIt input, const InputIt last, OutputIt output )
+{
+    uint64_t word = {};
+    int      size = {};
+
+    decode_blocks< DataT >( input, last, output, word, size );
+    write_bits< DataT >( output, word, size );
+
+    return output;
+}
+
+template< typename DataT, typename InputIt, typename OutputIt >
+constexpr OutputIt decode( InputIt input, InputIt last, OutputIt output, std::true_type )
+{
+    return decode_blocks< DataT >( input, last, output );
+}
+
+template< typename DataT, typename InputIt, typename OutputIt >
+constexpr OutputIt decode( InputIt input, InputIt last, OutputIt output, std::false_type )
 {
-    decoder< OutputValueT, InputIt > d( input, last );
+    decoder< DataT, InputIt > d( input, last );
 
     for( auto result = d.pull() ; result ; result = d.pull() )
     {
@@ -701,4 +1450,637 @@ constexpr auto decode( InputIt input, InputIt last, OutputIt output ) -> OutputI
 
 }
 
+namespace detail
+{
+
+template< typename InputIt >
+constexpr uint64_t sum_block_sizes( InputIt input, InputIt last )
+{
+    uint64_t bits = {};
+    while( input != last )
+    {
+        bits = bits + static_cast< uint64_t >( block_size( *input++ ) );
+    }
+
+    return bits;
+}
+
+//
+// Classifies 8 blocks at once in a 64-bit word.
+// The sizes of the blocks are summed in four 16-bit lanes which can hold the sizes of 256 words of blocks.
+//
+
+template< typename T >
+constexpr uint64_t sum_block_sizes( T * input, T * const last )
+{
+    constexpr uint64_t bytes = 0x0101010101010101u;
+    constexpr uint64_t lanes = 0x00FF00FF00FF00FFu;
+
+    uint64_t bits = {};
+    while( last - input >= 8 )
+    {
+        uint64_t sums = {};
+        for( int words = 0 ; words < 256 && last - input >= 8 ; ++words )
+        {
+            uint64_t blocks = {};
+            for( int i = 0 ; i < 8 ; ++i )
+            {
+                blocks = blocks | static_cast< uint64_t >( input[ i ] ) << ( 8 * i );
+            }
+            input = input + 8;
+
+            const auto runs   = ( ( blocks >> 7 ) & bytes ) * 0xFF;
+            const auto counts = blocks & ( 0x3F * bytes );
+            const auto max    = ( ( counts + bytes ) >> 6 ) & bytes;
+            const auto sizes  = ( ( counts + ( min_brle_len + 1 ) * bytes - max ) & runs ) | ( ( literal_size * bytes ) & ~runs );
+
+            sums = sums + ( sizes & lanes ) + ( ( sizes >> 8 ) & lanes );
+        }
+
+        bits = bits + ( sums & 0xFFFF ) + ( ( sums >> 16 ) & 0xFFFF ) + ( ( sums >> 32 ) & 0xFFFF ) + ( sums >> 48 );
+    }
+
+    return bits + sum_block_sizes< T * >( input, last );
+}
+
+}
+
+template< typename DataT = uint8_t, typename InputIt >
+constexpr auto decoded_size( InputIt input, InputIt last ) -> std::size_t
+{
+    static_assert( std::is_unsigned< DataT >::value, "expected an unsigned data type" );
+
+    return static_cast< std::size_t >( detail::sum_block_sizes( input, last ) / std::numeric_limits< DataT >::digits );
+}
+
+template< typename InputIt, typename OutputIt, typename OutputValueT = typename std::iterator_traits< OutputIt >::value_type >
+constexpr auto decode( InputIt input, InputIt last, OutputIt output ) -> OutputIt
+{
+    static_assert( std::is_unsigned< OutputValueT >::value, "expected an unsigned data type" );
+
+    // The table driven decoder handles the data types that fit a whole number of times in 64 bits.
+    constexpr auto digits = std::numeric_limits< OutputValueT >::digits;
+    using table_driven    = std::integral_constant< bool, digits <= 64 && 64 % digits == 0 >;
+
+    return detail::decode< OutputValueT >( input, last, output, table_driven() );
+}
+
+template< typename DataT, typename InputIt, typename OutputIt >
+constexpr auto decode_some( decoder< DataT, InputIt > & d, OutputIt output, OutputIt output_last ) -> OutputIt
+{
+    while( output != output_last )
+    {
+        const auto result = d.pull();
+        if( !result )
+        {
+            break;
+        }
+        *output++ = result.data;
+    }
+
+    return output;
+}
+
+namespace detail
+{
+
+struct bit_counts
+{
+    uint64_t bits = {};
+    uint64_t ones = {};
+};
+
+//
+// Returns the length and the number of set bits of the longest prefix of the first 'size' bits of a block
+// that has no more than 'max_bits' bits and no more than 'max_ones' set bits.
+//
+
+static constexpr bit_counts block_prefix( const brle8 rle, const int size, const uint64_t max_bits, const uint64_t max_ones )
+{
+    const auto n = static_cast< int >( std::min( static_cast< uint64_t >( size ), max_bits ) );
+
+    bit_counts prefix;
+
+    if( is_literal( rle ) )
+    {
+        auto bits = static_cast< uint8_t >( rle & low_mask< uint8_t >( n ) );
+
+        prefix.bits = static_cast< uint64_t >( n );
+        prefix.ones = static_cast< uint64_t >( popcount( bits ) );
+        if( prefix.ones > max_ones )
+        {
+            // Stop at the set bit that exceeds the limit.
+            for( auto i = max_ones ; i > 0 ; --i )
+            {
+                bits = static_cast< uint8_t >( bits & ( bits - 1 ) );
+            }
+            prefix.bits = static_cast< uint64_t >( countr_zero( bits ) );
+            prefix.ones = max_ones;
+        }
+
+        return prefix;
+    }
+
+    const auto c = count( rle );
+
+    if( brle8_mode( rle ) == mode::zeros )
+    {
+        // Only the stuffed bit after the zeros is set.
+        const auto stuffed = n > c && max_ones > 0;
+
+        prefix.bits = static_cast< uint64_t >( n > c && !stuffed ? c : n );
+        prefix.ones = stuffed ? 1 : 0;
+    }
+    else
+    {
+        const auto ones = static_cast< uint64_t >( std::min( n, c ) );
+
+        prefix.bits = ones > max_ones ? max_ones : static_cast< uint64_t >( n );
+        prefix.ones = std::min( ones, max_ones );
+    }
+
+    return prefix;
+}
+
+//
+// Counts the bits and the set bits of 8 blocks at once in a 64-bit word.
+// The set bits of the literal blocks are counted with a population count while the lengths of the runs are summed
+// in 16-bit lanes.
+//
+
+static constexpr bit_counts group_counts( const uint64_t blocks )
+{
+    constexpr uint64_t bytes = 0x0101010101010101u;
+    constexpr uint64_t lanes = 0x00FF00FF00FF00FFu;
+    constexpr uint64_t sum   = 0x0001000100010001u;
+
+    const auto runs    = ( ( blocks >> 7 ) & bytes ) * 0xFF;
+    const auto ones    = ( ( blocks >> 7 ) & ( blocks >> 6 ) & bytes ) * 0xFF;
+    const auto counts  = blocks & ( 0x3F * bytes );
+    const auto max     = ( ( counts + bytes ) >> 6 ) & bytes;
+    const auto sizes   = ( ( counts + ( min_brle_len + 1 ) * bytes - max ) & runs ) | ( ( literal_size * bytes ) & ~runs );
+    const auto lengths = ( counts + min_brle_len * bytes ) & ones;
+    const auto stuffed = runs & ~ones & ~max & bytes;
+
+    bit_counts group;
+
+    group.bits = ( ( ( sizes & lanes ) + ( ( sizes >> 8 ) & lanes ) ) * sum ) >> 48;
+    group.ones = ( ( ( ( lengths & lanes ) + ( ( lengths >> 8 ) & lanes ) ) * sum ) >> 48 ) +
+                 static_cast< uint64_t >( popcount( blocks & ~runs ) + popcount( stuffed ) );
+
+    return group;
+}
+
+//
+// Skips whole groups of 8 blocks as long as the counts stay within the limits.
+// Reading groups requires to look ahead in the input and is only done for raw pointers.
+//
+
+template< typename InputIt >
+constexpr void count_groups( InputIt &, InputIt, bit_counts &, uint64_t, uint64_t )
+{}
+
+template< typename T >
+constexpr void count_groups( T * & input, T * const last, bit_counts & counts, const uint64_t max_bits, const uint64_t max_ones )
+{
+    // The last block is left to the caller because it may contain padding bits.
+    while( last - input > 8 )
+    {
+        uint64_t blocks = {};
+        for( int i = 0 ; i < 8 ; ++i )
+        {
+            blocks = blocks | static_cast< uint64_t >( input[ i ] ) << ( 8 * i );
+        }
+
+        const auto group = group_counts( blocks );
+        if( counts.bits + group.bits > max_bits || counts.ones + group.ones > max_ones )
+        {
+            return;
+        }
+
+        counts.bits = counts.bits + group.bits;
+        counts.ones = counts.ones + group.ones;
+        input       = input + 8;
+    }
+}
+
+//
+// Returns the length and the number of set bits of the longest prefix of the decoded data
+// that has no more than 'max_bits' bits and no more than 'max_ones' set bits.
+//
+
+template< typename InputIt >
+constexpr bit_counts count_prefix( InputIt input, const InputIt last, const uint64_t max_bits, const uint64_t max_ones )
+{
+    bit_counts counts;
+
+    if( input == last )
+    {
+        return counts;
+    }
+
+    count_groups( input, last, counts, max_bits, max_ones );
+
+    while( true )
+    {
+        const brle8 rle     = *input++;
+        const auto  is_last = input == last;
+        auto        size    = block_size( rle );
+
+        // The encoded data is a whole number of bytes; the padding bits of the last block are not counted.
+        if( is_last )
+        {
+            const auto end = ( counts.bits + static_cast< uint64_t >( size ) ) & ~uint64_t( 7 );
+
+            size = end > counts.bits ? static_cast< int >( end - counts.bits ) : 0;
+        }
+
+        const auto prefix = block_prefix( rle, size, max_bits - counts.bits, max_ones - counts.ones );
+
+        counts.bits = counts.bits + prefix.bits;
+        counts.ones = counts.ones + prefix.ones;
+        if( is_last || prefix.bits < static_cast< uint64_t >( size ) )
+        {
+            return counts;
+        }
+    }
+}
+
+}
+
+template< typename InputIt >
+constexpr auto popcount( InputIt input, InputIt last ) -> uint64_t
+{
+    constexpr auto unlimited = std::numeric_limits< uint64_t >::max();
+
+    return detail::count_prefix( input, last, unlimited, unlimited ).ones;
+}
+
+template< typename InputIt >
+constexpr auto rank( InputIt input, InputIt last, uint64_t bit_pos ) -> uint64_t
+{
+    return detail::count_prefix( input, last, bit_pos, std::numeric_limits< uint64_t >::max() ).ones;
+}
+
+template< typename InputIt >
+constexpr auto select( InputIt input, InputIt last, uint64_t n ) -> uint64_t
+{
+    return detail::count_prefix( input, last, std::numeric_limits< uint64_t >::max(), n ).bits;
+}
+
+//
+// Calls 'visitor.run( bit, length )' for every zeros or ones block and 'visitor.literal( bits )' for every literal block
+// of the RLE data. The stuffed bit that terminates a run is passed as a run of length 1 with the opposite bit.
+// Successive blocks of the maximum count are passed as one run when the input is a raw pointer.
+//
+
+template< typename InputIt, typename Visitor >
+constexpr auto decode_runs( InputIt input, InputIt last, Visitor visitor ) -> Visitor
+{
+    while( input != last )
+    {
+        const brle8 rle = *input++;
+
+        if( detail::is_literal( rle ) )
+        {
+            visitor.literal( detail::make_literal( rle ) );
+            continue;
+        }
+
+        const auto bit    = detail::brle8_mode( rle ) == detail::mode::ones;
+        auto       length = static_cast< uint64_t >( detail::count( rle ) );
+
+        if( length == detail::max_count )
+        {
+            length = length + static_cast< uint64_t >( detail::skip_blocks( input, last, rle ) ) * detail::max_count;
+            visitor.run( bit, length );
+        }
+        else
+        {
+            visitor.run( bit, length );
+            visitor.run( !bit, uint64_t( 1 ) );
+        }
+    }
+
+    return visitor;
+}
+
+//
+// Calls 'f' with the position of every set bit in the RLE data.
+// Zeros blocks only advance the position and the positions of ones blocks are generated as a range.
+// The bits of literal blocks are visited with countr_zero.
+//
+
+template< typename InputIt, typename Function >
+constexpr auto for_each_set_bit( InputIt input, InputIt last, Function f ) -> Function
+{
+    uint64_t position = {};
+
+    while( input != last )
+    {
+        const brle8 rle  = *input++;
+        const auto  max  = rle == detail::make_zeros( detail::max_count ) || rle == detail::make_ones( detail::max_count );
+        auto        size = static_cast< uint64_t >( detail::block_size( rle ) );
+
+        if( max )
+        {
+            size = size + static_cast< uint64_t >( detail::skip_blocks( input, last, rle ) ) * detail::max_count;
+        }
+
+        // The encoded data is a whole number of bytes; the padding bits of the last block are not visited.
+        if( input == last )
+        {
+            const auto end = ( position + size ) & ~uint64_t( 7 );
+
+            size = end > position ? end - position : 0;
+        }
+
+        if( detail::is_literal( rle ) )
+        {
+            auto bits = static_cast< uint8_t >( rle & detail::low_mask< uint8_t >( static_cast< int >( std::min< uint64_t >( size, detail::literal_size ) ) ) );
+            for( ; bits ; bits = static_cast< uint8_t >( bits & ( bits - 1 ) ) )
+            {
+                f( position + static_cast< uint64_t >( detail::countr_zero( bits ) ) );
+            }
+        }
+        else if( detail::brle8_mode( rle ) == detail::mode::zeros )
+        {
+            const auto n = static_cast< uint64_t >( detail::count( rle ) );
+            if( !max && size > n )
+            {
+                f( position + n );
+            }
+        }
+        else
+        {
+            const auto n = max ? size : std::min( size, static_cast< uint64_t >( detail::count( rle ) ) );
+            for( uint64_t i = 0 ; i < n ; ++i )
+            {
+                f( position + i );
+            }
+        }
+
+        position = position + size;
+    }
+
+    return f;
+}
+
+namespace detail
+{
+
+//
+// Reads RLE data as spans of equal bits and spans of up to 7 literal bits.
+// The stuffed bit after a run is a span of one bit and successive runs of the maximum count are read as one span
+// when the input is a raw pointer.
+//
+
+template< typename InputIt >
+struct span_reader
+{
+    InputIt  input   = {};
+    InputIt  last    = {};
+    uint64_t bits    = {};
+    uint64_t size    = {};
+    bool     uniform = {};
+    bool     stuffed = {};
+
+    constexpr span_reader( InputIt input, InputIt last )
+        : input( input )
+        , last( last )
+    {}
+
+    constexpr bool next()
+    {
+        if( stuffed )
+        {
+            bits    = ~bits;
+            size    = 1;
+            stuffed = false;
+
+            return true;
+        }
+
+        if( input == last )
+        {
+            return false;
+        }
+
+        const brle8 rle = *input++;
+
+        if( is_literal( rle ) )
+        {
+            bits    = rle;
+            size    = literal_size;
+            uniform = false;
+
+            return true;
+        }
+
+        bits    = brle8_mode( rle ) == mode::ones ? ~uint64_t() : uint64_t();
+        size    = static_cast< uint64_t >( count( rle ) );
+        uniform = true;
+        stuffed = count( rle ) != max_count;
+        if( !stuffed )
+        {
+            size = size + static_cast< uint64_t >( skip_blocks( input, last, rle ) ) * max_count;
+        }
+
+        return true;
+    }
+
+    constexpr bool ready()
+    {
+        return size > 0 || next();
+    }
+
+    constexpr void consume( const uint64_t n )
+    {
+        assert( n <= size );
+
+        size = size - n;
+        if( !uniform )
+        {
+            bits = bits >> n;
+        }
+    }
+
+    // Consumes up to 'n' bits over as many spans as needed and returns the number of consumed bits.
+    constexpr uint64_t advance( uint64_t n )
+    {
+        uint64_t consumed = {};
+        while( n > 0 && ready() )
+        {
+            const auto bits_ = std::min( n, size );
+
+            consume( bits_ );
+            consumed = consumed + bits_;
+            n        = n - bits_;
+        }
+
+        return consumed;
+    }
+};
+
+//
+// Collects bits and pushes them in whole bytes to an encoder.
+// Bits that do not complete a byte at the end are dropped.
+//
+
+template< typename Encoder >
+class bit_writer
+{
+    Encoder & e;
+    uint64_t  word      = {};
+    int       word_size = {};
+
+    constexpr void push_bytes()
+    {
+        const auto size = word_size & ~7;
+
+        e.push_bits( word, size );
+        word      = size < 64 ? word >> size : 0;
+        word_size = word_size - size;
+    }
+
+public:
+    constexpr bit_writer( Encoder & e )
+        : e( e )
+    {}
+
+    // Writes up to 8 bits.
+    constexpr void write( const uint64_t bits, const int size )
+    {
+        word      = word | ( bits & low_mask< uint64_t >( size ) ) << word_size;
+        word_size = word_size + size;
+        if( word_size >= 56 )
+        {
+            push_bytes();
+        }
+    }
+
+    constexpr void fill( const bool value, uint64_t size )
+    {
+        const auto bits = value ? ~uint64_t() : uint64_t();
+        const auto head = std::min( size, static_cast< uint64_t >( ( 64 - word_size ) % 8 ) );
+
+        write( bits, static_cast< int >( head ) );
+        size = size - head;
+        if( size >= 8 )
+        {
+            push_bytes();
+            e.push_run( value, size & ~uint64_t( 7 ) );
+        }
+        write( bits, static_cast< int >( size & 7 ) );
+    }
+
+    constexpr auto flush() -> decltype( e.flush() )
+    {
+        push_bytes();
+
+        return e.flush();
+    }
+};
+
+//
+// Combines two RLE data streams span by span with 'op'.
+// When a run in one of the streams decides the result on its own, e.g. zeros for 'and', the other stream is skipped
+// for the length of that run without looking at its bits.
+//
+
+template< typename InputIt1, typename InputIt2, typename OutputIt, typename Op >
+constexpr OutputIt combine( InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, OutputIt output, Op op )
+{
+    constexpr auto zeros = uint64_t();
+    constexpr auto ones  = ~uint64_t();
+
+    span_reader< InputIt1 >       a( first1, last1 );
+    span_reader< InputIt2 >       b( first2, last2 );
+    encoder< uint64_t, OutputIt > e( output );
+    bit_writer< decltype( e ) >   w( e );
+
+    while( a.ready() && b.ready() )
+    {
+        if( a.uniform && op( a.bits, zeros ) == op( a.bits, ones ) )
+        {
+            const auto n = b.advance( a.size );
+
+            w.fill( op( a.bits, zeros ) != 0, n );
+            a.consume( n );
+        }
+        else if( b.uniform && op( zeros, b.bits ) == op( ones, b.bits ) )
+        {
+            const auto n = a.advance( b.size );
+
+            w.fill( op( zeros, b.bits ) != 0, n );
+            b.consume( n );
+        }
+        else
+        {
+            const auto n = std::min( a.size, b.size );
+
+            if( a.uniform && b.uniform )
+            {
+                w.fill( op( a.bits, b.bits ) != 0, n );
+            }
+            else
+            {
+                w.write( op( a.bits, b.bits ), static_cast< int >( n ) );
+            }
+            a.consume( n );
+            b.consume( n );
+        }
+    }
+
+    return w.flush();
+}
+
+struct and_op
+{
+    constexpr uint64_t operator()( const uint64_t a, const uint64_t b ) const { return a & b; }
+};
+
+struct or_op
+{
+    constexpr uint64_t operator()( const uint64_t a, const uint64_t b ) const { return a | b; }
+};
+
+struct xor_op
+{
+    constexpr uint64_t operator()( const uint64_t a, const uint64_t b ) const { return a ^ b; }
+};
+
+struct andnot_op
+{
+    constexpr uint64_t operator()( const uint64_t a, const uint64_t b ) const { return a & ~b; }
+};
+
+}
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+constexpr auto bitwise_and( InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, OutputIt output ) -> OutputIt
+{
+    return detail::combine( first1, last1, first2, last2, output, detail::and_op() );
+}
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+constexpr auto bitwise_or( InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, OutputIt output ) -> OutputIt
+{
+    return detail::combine( first1, last1, first2, last2, output, detail::or_op() );
+}
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+constexpr auto bitwise_xor( InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, OutputIt output ) -> OutputIt
+{
+    return detail::combine( first1, last1, first2, last2, output, detail::xor_op() );
+}
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+constexpr auto bitwise_andnot( InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, OutputIt output ) -> OutputIt
+{
+    return detail::combine( first1, last1, first2, last2, output, detail::andnot_op() );
+}
+
+}
+
 }
@@ -0,0 +1,287 @@
+// MIT License
+//
+// Copyright (c) 2021 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "brle.h"
+
+#include <vector>
+
+namespace pg
+{
+
+namespace brle
+{
+
+//
+// Optional container format on top of the RLE data.
+//
+// A frame starts with a header of 24 bytes;
+//   - the magic 'BRLE' and a version byte followed by 3 reserved bytes,
+//   - the size of the original data in bytes as a 64-bit value,
+//   - the number of bytes of original data per chunk as 32-bit value,
+//   - the number of chunks as a 32-bit value, a frame holds at most 2^32 - 1 chunks.
+// A table with the decoded size and the encoded size of each chunk as 32-bit values follows the header.
+// Then the RLE data of the chunks follow one after another. Each chunk is encoded on its own and can be decoded
+// without the other chunks. All values are stored in little endian byte order.
+//
+
+namespace detail
+{
+
+static constexpr uint8_t     frame_magic[ 4 ]  = { 'B', 'R', 'L', 'E' };
+static constexpr uint8_t     frame_version     = 1;
+static constexpr std::size_t frame_header_size = 24;
+static constexpr std::size_t frame_entry_size  = 8;
+
+template< typename OutputIt >
+void write_le( OutputIt & output, const uint64_t value, const int bytes )
+{
+    for( int i = 0 ; i < bytes ; ++i )
+    {
+        *output++ = static_cast< uint8_t >( value >> ( 8 * i ) );
+    }
+}
+
+static inline uint64_t read_le( const uint8_t * const input, const int bytes )
+{
+    uint64_t value = {};
+    for( int i = 0 ; i < bytes ; ++i )
+    {
+        value = value | static_cast< uint64_t >( input[ i ] ) << ( 8 * i );
+    }
+
+    return value;
+}
+
+}
+
+//
+// The largest chunk size for which the encoded size of a chunk always fits in the 32-bit entries of the chunk table.
+//
+
+static constexpr uint32_t max_frame_chunk_size =
+    static_cast< uint32_t >( ( ( uint64_t( std::numeric_limits< uint32_t >::max() ) - 1 ) * detail::literal_size - 1 ) / 8 );
+
+namespace detail
+{
+
+// Returns the chunk size that encode_frame uses for 'size' bytes of data when 'chunk_size' is requested.
+// The chunk size is limited to max_frame_chunk_size and raised when the number of chunks would not fit in 32 bits.
+static constexpr uint32_t frame_chunk_size( const uint64_t size, const uint32_t chunk_size )
+{
+    constexpr uint64_t max_chunks = std::numeric_limits< uint32_t >::max();
+
+    const auto min_chunk_size = size / max_chunks + ( size % max_chunks != 0 );
+
+    assert( min_chunk_size <= max_frame_chunk_size );
+
+    return static_cast< uint32_t >( std::max< uint64_t >( std::min( chunk_size, max_frame_chunk_size ), min_chunk_size ) );
+}
+
+}
+
+struct frame_chunk
+{
+    const brle8 * first         = {};
+    const brle8 * last          = {};
+    uint64_t      output_offset = {};
+    std::size_t   output_size   = {};
+};
+
+//
+// Parses a frame and gives access to its chunks.
+// A frame that is truncated or has inconsistent sizes is not valid.
+//
+
+class frame_reader
+{
+    const uint8_t *         data        = {};
+    uint64_t                size        = {};
+    uint32_t                chunk_size  = {};
+    std::vector< uint64_t > offsets;
+    bool                    is_valid    = {};
+
+public:
+    frame_reader( const uint8_t * first, const uint8_t * last )
+        : data( first )
+    {
+        const auto length = static_cast< std::size_t >( last - first );
+        if( length < detail::frame_header_size ||
+            !std::equal( std::begin( detail::frame_magic ), std::end( detail::frame_magic ), first ) ||
+            first[ 4 ] != detail::frame_version )
+        {
+            return;
+        }
+
+        size       = detail::read_le( first + 8, 8 );
+        chunk_size = static_cast< uint32_t >( detail::read_le( first + 16, 4 ) );
+
+        const auto count = static_cast< std::size_t >( detail::read_le( first + 20, 4 ) );
+        if( count > ( length - detail::frame_header_size ) / detail::frame_entry_size ||
+            ( size > 0 && ( chunk_size == 0 || chunk_size > max_frame_chunk_size || count != ( size + chunk_size - 1 ) / chunk_size ) ) ||
+            ( size == 0 && count != 0 ) )
+        {
+            return;
+        }
+
+        // The offsets of the chunks relative to the start of the frame.
+        offsets.resize( count + 1 );
+        offsets[ 0 ] = detail::frame_header_size + count * detail::frame_entry_size;
+
+        for( std::size_t i = 0 ; i < count ; ++i )
+        {
+            const auto entry = first + detail::frame_header_size + i * detail::frame_entry_size;
+
+            if( detail::read_le( entry, 4 ) != std::min< uint64_t >( chunk_size, size - i * chunk_size ) )
+            {
+                return;
+            }
+            offsets[ i + 1 ] = offsets[ i ] + detail::read_le( entry + 4, 4 );
+        }
+
+        is_valid = offsets[ count ] <= length;
+    }
+
+    bool valid() const
+    {
+        return is_valid;
+    }
+
+    uint64_t original_size() const
+    {
+        return size;
+    }
+
+    std::size_t chunk_count() const
+    {
+        return is_valid ? offsets.size() - 1 : 0;
+    }
+
+    frame_chunk chunk( const std::size_t i ) const
+    {
+        assert( i < chunk_count() );
+
+        const auto entry = data + detail::frame_header_size + i * detail::frame_entry_size;
+
+        frame_chunk c;
+        c.first         = data + offsets[ i ];
+        c.last          = data + offsets[ i + 1 ];
+        c.output_offset = static_cast< uint64_t >( i ) * chunk_size;
+        c.output_size   = static_cast< std::size_t >( detail::read_le( entry, 4 ) );
+
+        return c;
+    }
+};
+
+//
+// Encodes the data from 'first' until 'last' in chunks of 'chunk_size' bytes and writes a frame to 'output'.
+// A chunk size larger than max_frame_chunk_size is reduced to max_frame_chunk_size. A chunk size that results in
+// more than 2^32 - 1 chunks is raised to the smallest size for which the number of chunks fits in the header.
+//
+
+template< typename OutputIt >
+auto encode_frame( const uint8_t * first, const uint8_t * last, OutputIt output, uint32_t chunk_size = 1u << 20 ) -> OutputIt
+{
+    assert( chunk_size > 0 );
+
+    const auto size = static_cast< uint64_t >( last - first );
+
+    chunk_size = detail::frame_chunk_size( size, chunk_size );
+
+    const auto count = static_cast< std::size_t >( ( size + chunk_size - 1 ) / chunk_size );
+
+    std::vector< std::vector< brle8 > > chunks( count );
+    for( std::size_t i = 0 ; i < count ; ++i )
+    {
+        const auto chunk_first = first + i * chunk_size;
+        const auto chunk_last  = static_cast< uint64_t >( last - chunk_first ) > chunk_size ? chunk_first + chunk_size : last;
+
+        chunks[ i ].resize( static_cast< std::size_t >( detail::max_blocks( 8 * ( chunk_last - chunk_first ) ) ) );
+        chunks[ i ].resize( static_cast< std::size_t >( encode( chunk_first, chunk_last, chunks[ i ].data() ) - chunks[ i ].data() ) );
+    }
+
+    output = std::copy( std::begin( detail::frame_magic ), std::end( detail::frame_magic ), output );
+    detail::write_le( output, detail::frame_version, 4 );
+    detail::write_le( output, size, 8 );
+    detail::write_le( output, chunk_size, 4 );
+    detail::write_le( output, count, 4 );
+
+    for( std::size_t i = 0 ; i < count ; ++i )
+    {
+        detail::write_le( output, std::min< uint64_t >( chunk_size, size - i * chunk_size ), 4 );
+        detail::write_le( output, chunks[ i ].size(), 4 );
+    }
+
+    for( const auto & chunk : chunks )
+    {
+        output = std::copy( chunk.begin(), chunk.end(), output );
+    }
+
+    return output;
+}
+
+//
+// Decodes a chunk of a frame to 'output', which is the start of the output for the whole frame.
+// Returns false when the chunk does not decode to its recorded size; nothing is written in that case.
+//
+
+inline bool decode_chunk( const frame_chunk & chunk, uint8_t * const output )
+{
+    if( decoded_size( chunk.first, chunk.last ) != chunk.output_size )
+    {
+        return false;
+    }
+
+    decode( chunk.first, chunk.last, output + chunk.output_offset );
+
+    return true;
+}
+
+//
+// Decodes the frame from 'first' until 'last' to 'output' and returns the end of the decoded data.
+// 'output' must have room for the original size of the frame. Returns a null pointer when the frame is not valid.
+//
+
+inline auto decode_frame( const uint8_t * first, const uint8_t * last, uint8_t * output ) -> uint8_t *
+{
+    const frame_reader frame( first, last );
+    if( !frame.valid() )
+    {
+        return nullptr;
+    }
+
+    for( std::size_t i = 0 ; i < frame.chunk_count() ; ++i )
+    {
+        if( !decode_chunk( frame.chunk( i ), output ) )
+        {
+            return nullptr;
+        }
+    }
+
+    return output + frame.original_size();
+}
+
+}
+
+}
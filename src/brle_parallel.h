@@ -0,0 +1,342 @@
+// MIT License
+//
+// Copyright (c) 2021 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "brle.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace pg
+{
+
+namespace brle
+{
+
+namespace detail
+{
+
+//
+// Returns the number of successive bits from bit 'pos' that are equal to that bit, without passing bit 'end'.
+//
+
+template< typename T >
+uint64_t run_length( const T * const data, const uint64_t pos, const uint64_t end )
+{
+    constexpr auto digits = std::numeric_limits< T >::digits;
+
+    const auto invert = ( data[ pos / digits ] >> ( pos % digits ) ) & 1 ? std::numeric_limits< T >::max() : T();
+
+    auto it = pos;
+    while( it < end )
+    {
+        const auto offset = static_cast< int >( it % digits );
+        const auto value  = static_cast< T >( static_cast< T >( data[ it / digits ] ^ invert ) >> offset );
+        const auto n      = std::min( static_cast< int >( countr_zero( value ) ), digits - offset );
+
+        it = it + static_cast< uint64_t >( n );
+        if( n < digits - offset || it >= end )
+        {
+            break;
+        }
+
+        // Values in which all bits are equal are skipped at once.
+        it = it + static_cast< uint64_t >( uniform_length( data + it / digits, data + end / digits, invert ) ) * digits;
+    }
+
+    return std::min( it, end ) - pos;
+}
+
+//
+// Returns the first bit position from 'pos' at which the encoder is in its initial state with an empty buffer,
+// regardless of the data that precedes it, or 'end' when there is no such position.
+//
+// That is the bit after the terminator of a run of 14 until 70 equal bits.
+// The encoder starts a zeros or ones block within the first 7 bits of such a run and because the run is shorter
+// than the maximum count, the block ends with the terminator as stuffed bit.
+//
+
+template< typename T >
+uint64_t find_sync_point( const T * const data, uint64_t pos, const uint64_t end )
+{
+    // The run that contains 'pos' may start before it so its length is unknown.
+    pos = pos + run_length( data, pos, end );
+
+    while( pos < end )
+    {
+        const auto n = run_length( data, pos, end );
+        if( n >= 2 * literal_size && n < max_count && pos + n < end )
+        {
+            return pos + n + 1;
+        }
+        pos = pos + n;
+    }
+
+    return end;
+}
+
+struct chunk
+{
+    std::unique_ptr< brle8[] > data;
+    std::size_t                size = {};
+};
+
+//
+// Encodes the bits from bit 'first' until bit 'last' as if they are a complete input.
+// The output buffer is sized for the worst case but left uninitialized so that only the used part is touched.
+//
+
+template< typename T >
+chunk encode_bits( const T * const data, uint64_t first, const uint64_t last )
+{
+    constexpr auto digits = std::numeric_limits< T >::digits;
+
+    chunk                 rle = { std::unique_ptr< brle8[] >( new brle8[ max_blocks( static_cast< std::ptrdiff_t >( last - first ) ) ] ) };
+    encoder< T, brle8 * > e( rle.data.get() );
+
+    while( first < last && first % digits != 0 )
+    {
+        const auto n = static_cast< int >( std::min< uint64_t >( digits - first % digits, last - first ) );
+
+        e.push_bits( static_cast< T >( data[ first / digits ] >> ( first % digits ) ), n );
+        first = first + static_cast< uint64_t >( n );
+    }
+
+    const auto whole = first + ( last - first ) / digits * digits;
+
+    e.push( data + first / digits, data + whole / digits );
+    if( whole < last )
+    {
+        e.push_bits( data[ whole / digits ], static_cast< int >( last - whole ) );
+    }
+
+    rle.size = static_cast< std::size_t >( e.flush() - rle.data.get() );
+
+    return rle;
+}
+
+}
+
+//
+// Encodes the data from 'first' until 'last' with 'threads' threads and writes exactly the same RLE values
+// as 'encode' to 'output'.
+//
+// The data is split at positions where the encoder state does not depend on the data before it,
+// so that each chunk is encoded on its own without fixing up the blocks at the boundaries.
+// When the data has no such positions, like a long sequence of zeros, it is encoded in fewer chunks.
+//
+
+template< typename DataT, typename OutputIt >
+auto parallel_encode( const DataT * first, const DataT * last, OutputIt output, unsigned threads = std::thread::hardware_concurrency() ) -> OutputIt
+{
+    static_assert( std::is_unsigned< DataT >::value, "expected an unsigned data type" );
+
+    constexpr auto digits = std::numeric_limits< DataT >::digits;
+
+    const auto bits = static_cast< uint64_t >( last - first ) * digits;
+
+    threads = std::max( 1u, std::min( threads, static_cast< unsigned >( bits / ( 1 << 16 ) ) ) );
+    if( threads == 1 )
+    {
+        return encode( first, last, output );
+    }
+
+    std::vector< detail::chunk > chunks( threads );
+    std::vector< std::thread >   workers;
+
+    const auto encode_chunk = [ & ]( const unsigned i )
+    {
+        const auto begin = i == 0 ? 0 : detail::find_sync_point( first, bits / threads * i, bits );
+        const auto end   = i + 1 == threads ? bits : detail::find_sync_point( first, bits / threads * ( i + 1 ), bits );
+
+        if( begin < end )
+        {
+            chunks[ i ] = detail::encode_bits( first, begin, end );
+        }
+    };
+
+    for( unsigned i = 1 ; i < threads ; ++i )
+    {
+        workers.emplace_back( encode_chunk, i );
+    }
+    encode_chunk( 0 );
+
+    for( auto & worker : workers )
+    {
+        worker.join();
+    }
+
+    for( const auto & chunk : chunks )
+    {
+        output = std::copy( chunk.data.get(), chunk.data.get() + chunk.size, output );
+    }
+
+    return output;
+}
+
+namespace detail
+{
+
+//
+// The bits at the edges of a segment that is decoded by a thread.
+// The first word is shared with the previous segment and the bits that do not fill a whole word at the end are
+// shared with the next segment. These are merged after all segments are decoded.
+//
+
+struct segment_edges
+{
+    uint64_t head      = {};
+    bool     has_head  = {};
+    uint64_t tail      = {};
+    int      tail_size = {};
+};
+
+template< typename DataT >
+segment_edges decode_segment( const brle8 * input, const brle8 * const last, DataT * const output, const uint64_t bit_offset )
+{
+    constexpr auto word_size = std::numeric_limits< uint64_t >::digits;
+    constexpr auto values    = word_size / std::numeric_limits< DataT >::digits;
+
+    segment_edges edges;
+
+    auto     out  = output + bit_offset / word_size * values;
+    uint64_t word = {};
+    int      size = static_cast< int >( bit_offset % word_size );
+
+    // The first word is decoded a block at a time into a local buffer until it is complete.
+    if( size > 0 )
+    {
+        DataT head[ 3 * values ] = {};
+        auto  it                 = head;
+
+        while( input != last && it == head )
+        {
+            decode_blocks< DataT >( input, input + 1, it, word, size );
+            ++input;
+        }
+
+        if( it != head )
+        {
+            for( std::size_t i = 0 ; i < values ; ++i )
+            {
+                edges.head = edges.head | static_cast< uint64_t >( head[ i ] ) << ( i * word_size / values );
+            }
+            edges.has_head = true;
+
+            out = std::copy( head + values, it, out + values );
+        }
+    }
+
+    decode_blocks< DataT >( input, last, out, word, size );
+
+    edges.tail      = word & low_mask< uint64_t >( size );
+    edges.tail_size = size;
+
+    return edges;
+}
+
+}
+
+//
+// Decodes the RLE values from 'first' until 'last' with 'threads' threads into 'output' and returns the same as
+// 'decode'.
+//
+// The RLE values are divided in segments of equal size. Each thread sums the sizes of the blocks in its segment and
+// a prefix sum of these sizes gives the position in the output where each segment starts. Then each thread decodes
+// its segment into the output. The words that are shared by two segments are merged at the end.
+//
+
+template< typename DataT >
+auto parallel_decode( const brle8 * first, const brle8 * last, DataT * output, unsigned threads = std::thread::hardware_concurrency() ) -> DataT *
+{
+    static_assert( std::is_unsigned< DataT >::value, "expected an unsigned data type" );
+
+    constexpr auto word_size = std::numeric_limits< uint64_t >::digits;
+    constexpr auto digits    = std::numeric_limits< DataT >::digits;
+
+    const auto size = static_cast< std::size_t >( last - first );
+
+    threads = std::max( 1u, std::min( threads, static_cast< unsigned >( size / ( 1 << 16 ) ) ) );
+    if( threads == 1 || digits > word_size || word_size % digits != 0 )
+    {
+        return decode( first, last, output );
+    }
+
+    const auto segment_first = [ & ]( const unsigned i ) { return first + size / threads * i; };
+    const auto segment_last  = [ & ]( const unsigned i ) { return i + 1 == threads ? last : segment_first( i + 1 ); };
+
+    std::vector< uint64_t >              offsets( threads + 1 );
+    std::vector< detail::segment_edges > edges( threads );
+    std::vector< std::thread >           workers;
+
+    const auto run = [ & ]( const auto & task )
+    {
+        workers.clear();
+        for( unsigned i = 1 ; i < threads ; ++i )
+        {
+            workers.emplace_back( task, i );
+        }
+        task( 0 );
+
+        for( auto & worker : workers )
+        {
+            worker.join();
+        }
+    };
+
+    run( [ & ]( const unsigned i ) { offsets[ i + 1 ] = detail::sum_block_sizes( segment_first( i ), segment_last( i ) ); } );
+
+    for( unsigned i = 0 ; i < threads ; ++i )
+    {
+        offsets[ i + 1 ] = offsets[ i ] + offsets[ i + 1 ];
+    }
+
+    run( [ & ]( const unsigned i ) { edges[ i ] = detail::decode_segment( segment_first( i ), segment_last( i ), output, offsets[ i ] ); } );
+
+    // Merge the words that are shared by segments.
+    uint64_t word = {};
+    int      bits = {};
+    for( unsigned i = 0 ; i < threads ; ++i )
+    {
+        if( edges[ i ].has_head )
+        {
+            auto out = output + offsets[ i ] / word_size * ( word_size / digits );
+            detail::write_bits< DataT >( out, word | edges[ i ].head, word_size );
+
+            word = {};
+        }
+        word = word | edges[ i ].tail;
+        bits = edges[ i ].tail_size;
+    }
+
+    auto out = output + offsets[ threads ] / word_size * ( word_size / digits );
+    detail::write_bits< DataT >( out, word, bits );
+
+    return out;
+}
+
+}
+
+}
@@ -1,6 +1,9 @@
 #include <brle.h>
+#include <brle_parallel.h>
+#include <brle_frame.h>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 
@@ -40,6 +43,18 @@ static bool roundtrip( const T ( & in )[ N ], U init = U() )
            memcmp( in, decode_buffer, ( 7 + len ) / 8 ) == 0;   // Same contents as in.
 }
 
+template< typename T >
+static bool roundtrip( const std::vector< T > & in )
+{
+    std::vector< brle8 > encode_buffer( 2 * in.size() * sizeof( T ) + 1 );
+    std::vector< T >     decode_buffer( in.size() );
+
+    const auto encode_result = encode( in.data(), in.data() + in.size(), encode_buffer.data() );
+    const auto decode_result = decode( encode_buffer.data(), encode_result, decode_buffer.data() );
+
+    return decode_result == decode_buffer.data() + decode_buffer.size() && decode_buffer == in;
+}
+
 static void encode_decode_uint8()
 {
     const uint8_t zeros[]         = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
@@ -160,6 +175,817 @@ static void bitmap_header()
     assert_true( roundtrip( header ) );
 }
 
+// Generates data with runs of zeros and ones of various lengths mixed with some noise.
+template< typename T >
+static std::vector< T > make_runs( size_t size, uint32_t seed )
+{
+    std::vector< T > data( size );
+
+    size_t i = 0;
+    while( i < size )
+    {
+        seed = seed * 1103515245u + 12345u;
+
+        const auto kind = ( seed >> 8 ) % 4u;
+        const auto len  = std::min< size_t >( size - i, 1 + ( seed >> 12 ) % 300u );
+        const auto fill = kind == 0 ? T() : kind == 1 ? std::numeric_limits< T >::max() : static_cast< T >( seed * 2654435761u );
+
+        std::fill( data.begin() + i, data.begin() + i + len, fill );
+        if( kind == 3 )
+        {
+            data[ i ] = static_cast< T >( seed >> 3 );
+        }
+        i = i + len;
+    }
+
+    return data;
+}
+
+template< typename T >
+static std::vector< T > make_noise( size_t size, uint32_t seed )
+{
+    std::vector< T > data( size );
+
+    for( auto & value : data )
+    {
+        seed  = seed * 1103515245u + 12345u;
+        value = static_cast< T >( static_cast< uint64_t >( seed ) << 32 | ( seed * 2654435761u ) );
+    }
+
+    return data;
+}
+
+template< typename T >
+static bool same_encoding( const std::vector< T > & in )
+{
+    std::vector< brle8 > generic( 2 * in.size() * sizeof( T ) + 1 );
+    std::vector< brle8 > contiguous( generic.size() );
+
+    const auto generic_end    = encode( in.begin(), in.end(), generic.begin() );
+    const auto contiguous_end = encode( in.data(), in.data() + in.size(), contiguous.data() );
+
+    const auto size = static_cast< size_t >( std::distance( generic.begin(), generic_end ) );
+
+    return size == static_cast< size_t >( std::distance( contiguous.data(), contiguous_end ) ) &&
+           std::equal( generic.begin(), generic_end, contiguous.data() );
+}
+
+template< typename T >
+static void encode_contiguous_type()
+{
+    for( uint32_t seed = 1 ; seed < 16 ; ++seed )
+    {
+        assert_true( same_encoding( make_runs< T >( 4096, seed ) ) );
+        assert_true( roundtrip( make_runs< T >( 4096, seed ) ) );
+        assert_true( same_encoding( make_noise< T >( 1024 + seed, seed ) ) );
+        assert_true( roundtrip( make_noise< T >( 1024 + seed, seed ) ) );
+    }
+
+    for( size_t size = 0 ; size < 80 ; ++size )
+    {
+        assert_true( same_encoding( std::vector< T >( size, T() ) ) );
+        assert_true( same_encoding( std::vector< T >( size, std::numeric_limits< T >::max() ) ) );
+    }
+}
+
+// Runs that end at every offset around the blocks that are compared at once by the run scanner.
+template< typename T >
+static void encode_contiguous_boundaries()
+{
+    const T values[] = { T(), std::numeric_limits< T >::max() };
+
+    for( const auto value : values )
+    {
+        for( size_t length = 1 ; length < 200 ; length = length + 3 )
+        {
+            std::vector< T > data( 2 * length + 16, value );
+            data[ length ] = static_cast< T >( 0x5A );
+
+            for( size_t offset = 0 ; offset < 16 ; ++offset )
+            {
+                assert_true( same_encoding( std::vector< T >( data.begin() + offset, data.end() ) ) );
+            }
+        }
+    }
+}
+
+static void encode_contiguous()
+{
+    encode_contiguous_type< uint8_t >();
+    encode_contiguous_type< uint16_t >();
+    encode_contiguous_type< uint32_t >();
+    encode_contiguous_type< uint64_t >();
+    encode_contiguous_boundaries< uint8_t >();
+    encode_contiguous_boundaries< uint64_t >();
+}
+
+// Compares the output of the decode function with the values pulled one by one from a decoder.
+template< typename T >
+static bool same_decoding( const std::vector< brle8 > & rle )
+{
+    std::vector< T > pulled;
+    decoder< T, const brle8 * > d( rle.data(), rle.data() + rle.size() );
+    for( auto result = d.pull() ; result ; result = d.pull() )
+    {
+        pulled.push_back( result.data );
+    }
+
+    std::vector< T > decoded( pulled.size() + 1 );
+    const auto decoded_end = decode( rle.begin(), rle.end(), decoded.begin() );
+
+    std::vector< T > contiguous( pulled.size() + 1 );
+    const auto contiguous_end = decode( rle.data(), rle.data() + rle.size(), contiguous.data() );
+
+    return std::distance( decoded.begin(), decoded_end ) == static_cast< std::ptrdiff_t >( pulled.size() ) &&
+           std::distance( contiguous.data(), contiguous_end ) == static_cast< std::ptrdiff_t >( pulled.size() ) &&
+           std::equal( pulled.begin(), pulled.end(), decoded.begin() ) &&
+           std::equal( pulled.begin(), pulled.end(), contiguous.begin() );
+}
+
+template< typename T >
+static void decode_table_driven_type()
+{
+    std::vector< brle8 > all_blocks( 256 );
+    for( size_t i = 0 ; i < all_blocks.size() ; ++i )
+    {
+        all_blocks[ i ] = static_cast< brle8 >( i );
+    }
+    assert_true( same_decoding< T >( all_blocks ) );
+
+    for( uint32_t seed = 1 ; seed < 16 ; ++seed )
+    {
+        assert_true( same_decoding< T >( make_noise< brle8 >( 1000 + seed, seed ) ) );
+    }
+
+    // Successive blocks of the maximum count, which are decoded as whole words, at every bit offset.
+    for( int offset = 0 ; offset < 64 ; ++offset )
+    {
+        for( size_t blocks = 1 ; blocks < 20 ; blocks = blocks + 3 )
+        {
+            std::vector< brle8 > rle( offset / 7, 0x2A );
+            rle.push_back( static_cast< brle8 >( 0xC0 | offset % 7 ) );
+            rle.insert( rle.end(), blocks, 0xBF );
+            rle.push_back( 0x55 );
+            rle.insert( rle.end(), blocks, 0xFF );
+            rle.insert( rle.end(), blocks, 0xBF );
+            rle.push_back( 0x90 );
+
+            assert_true( same_decoding< T >( rle ) );
+        }
+    }
+}
+
+static void decode_table_driven()
+{
+    decode_table_driven_type< uint8_t >();
+    decode_table_driven_type< uint16_t >();
+    decode_table_driven_type< uint32_t >();
+    decode_table_driven_type< uint64_t >();
+}
+
+template< typename T >
+static bool exact_sizes( const std::vector< T > & in )
+{
+    std::vector< brle8 > rle( 2 * in.size() * sizeof( T ) + 1 );
+    rle.resize( std::distance( rle.data(), encode( in.data(), in.data() + in.size(), rle.data() ) ) );
+
+    std::vector< T > out( in.size() + 2 );
+    const auto out_size = static_cast< size_t >( std::distance( out.data(), decode( rle.data(), rle.data() + rle.size(), out.data() ) ) );
+
+    return encoded_size( in.data(), in.data() + in.size() ) == rle.size() &&
+           encoded_size( in.begin(), in.end() ) == rle.size() &&
+           decoded_size< T >( rle.data(), rle.data() + rle.size() ) == out_size &&
+           decoded_size< T >( rle.begin(), rle.end() ) == out_size &&
+           out_size == in.size();
+}
+
+static void size_functions()
+{
+    for( uint32_t seed = 1 ; seed < 8 ; ++seed )
+    {
+        assert_true( exact_sizes( make_runs< uint8_t >( 5000 + seed, seed ) ) );
+        assert_true( exact_sizes( make_runs< uint16_t >( 5000 + seed, seed ) ) );
+        assert_true( exact_sizes( make_noise< uint32_t >( 1000 + seed, seed ) ) );
+        assert_true( exact_sizes( make_runs< uint64_t >( 1000 + seed, seed ) ) );
+    }
+
+    const brle8 rle[] = { 0xCC, 0x9C, 0x2A };
+
+    assert_true( encoded_size( std::begin( rle ), std::begin( rle ) ) == 0u );
+    assert_true( decoded_size( std::begin( rle ), std::end( rle ) ) == 8u );
+    assert_true( decoded_size< uint16_t >( std::begin( rle ), std::end( rle ) ) == 4u );
+    assert_true( decoded_size< uint64_t >( std::begin( rle ), std::end( rle ) ) == 1u );
+}
+
+// Encodes and decodes through small fixed size buffers while the input arrives in chunks.
+template< typename T >
+static bool bounded_roundtrip( const std::vector< T > & in, const size_t buffer_size, const size_t chunk_size )
+{
+    std::vector< brle8 > expected( 2 * in.size() * sizeof( T ) + 1 );
+    expected.resize( std::distance( expected.data(), encode( in.data(), in.data() + in.size(), expected.data() ) ) );
+
+    std::vector< brle8 > rle;
+    brle8                rle_buffer[ 64 ];
+    encoder< T, brle8 * > e( rle_buffer );
+
+    for( size_t i = 0 ; i < in.size() ; i = i + chunk_size )
+    {
+        const auto last = in.data() + std::min( in.size(), i + chunk_size );
+        for( auto input = in.data() + i ; input != last ; )
+        {
+            input = encode_some( e, input, last, rle_buffer + buffer_size );
+            rle.insert( rle.end(), rle_buffer, e.get_output() );
+            e.set_output( rle_buffer );
+        }
+    }
+    rle.insert( rle.end(), rle_buffer, e.flush() );
+
+    std::vector< T > out;
+    T                out_buffer[ 16 ];
+    decoder< T, const brle8 * > d;
+
+    for( size_t i = 0 ; i < rle.size() ; i = i + chunk_size )
+    {
+        d.set_input( rle.data() + i, rle.data() + std::min( rle.size(), i + chunk_size ) );
+        while( true )
+        {
+            const auto output = decode_some( d, out_buffer, out_buffer + std::min< size_t >( buffer_size, 16 ) );
+            out.insert( out.end(), out_buffer, output );
+            if( output == out_buffer )
+            {
+                break;
+            }
+        }
+    }
+
+    return rle == expected && out == in;
+}
+
+static void bounded_output()
+{
+    for( uint32_t seed = 1 ; seed < 4 ; ++seed )
+    {
+        const size_t chunk_sizes[] = { 1, 7, 100, 100000 };
+        for( const auto chunk_size : chunk_sizes )
+        {
+            assert_true( bounded_roundtrip( make_runs< uint8_t >( 3000, seed ), 4, chunk_size ) );
+            assert_true( bounded_roundtrip( make_runs< uint8_t >( 3000, seed ), 13, chunk_size ) );
+            assert_true( bounded_roundtrip( make_noise< uint16_t >( 1000, seed ), 7, chunk_size ) );
+            assert_true( bounded_roundtrip( make_runs< uint32_t >( 1000, seed ), 12, chunk_size ) );
+            assert_true( bounded_roundtrip( make_runs< uint64_t >( 1000, seed ), 20, chunk_size ) );
+            assert_true( bounded_roundtrip( make_noise< uint64_t >( 1000, seed ), 64, chunk_size ) );
+        }
+    }
+}
+
+template< typename T >
+static bool seek_all( const std::vector< uint8_t > & in, const std::vector< brle8 > & rle, const std::vector< checkpoint > & index )
+{
+    constexpr int digits = std::numeric_limits< T >::digits;
+
+    const auto bit = [ & ]( size_t i ) { return static_cast< T >( ( in[ i / 8 ] >> ( i % 8 ) ) & 1 ); };
+
+    decoder< T, const brle8 * > d( rle.data(), rle.data() + rle.size() );
+    for( size_t offset = 0 ; offset + digits <= 8 * in.size() ; offset = offset + 37 )
+    {
+        if( !d.seek( rle.data(), index.begin(), index.end(), offset ) )
+        {
+            return false;
+        }
+
+        T expected = {};
+        for( int i = 0 ; i < digits ; ++i )
+        {
+            expected = static_cast< T >( expected | bit( offset + i ) << i );
+        }
+
+        const auto result = d.pull();
+        if( !result || result.data != expected )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void random_access()
+{
+    for( uint32_t seed = 1 ; seed < 4 ; ++seed )
+    {
+        const auto in = make_runs< uint8_t >( 3000, seed );
+
+        std::vector< brle8 > rle( 2 * in.size() );
+        rle.resize( std::distance( rle.data(), encode( in.data(), in.data() + in.size(), rle.data() ) ) );
+
+        const uint64_t intervals[] = { 1, 64, 1000, 100000 };
+        for( const auto interval : intervals )
+        {
+            std::vector< checkpoint > index;
+            build_index( rle.begin(), rle.end(), interval, std::back_inserter( index ) );
+
+            assert_true( !index.empty() && index.front().input_offset == 0u && index.front().bit_offset == 0u );
+            assert_true( seek_all< uint8_t >( in, rle, index ) );
+            assert_true( seek_all< uint16_t >( in, rle, index ) );
+            assert_true( seek_all< uint64_t >( in, rle, index ) );
+        }
+
+        assert_true( seek_all< uint32_t >( in, rle, std::vector< checkpoint >() ) );
+
+        decoder< uint8_t, const brle8 * > d( rle.data(), rle.data() + rle.size() );
+        assert_false( d.seek( rle.data(), static_cast< checkpoint * >( nullptr ), static_cast< checkpoint * >( nullptr ), 8 * rle.size() * 72 ) );
+    }
+}
+
+template< typename T >
+static bool same_counts( const std::vector< T > & in )
+{
+    constexpr size_t digits = std::numeric_limits< T >::digits;
+
+    std::vector< brle8 > rle( 2 * in.size() * sizeof( T ) + 1 );
+    rle.resize( std::distance( rle.data(), encode( in.data(), in.data() + in.size(), rle.data() ) ) );
+
+    std::vector< uint64_t > positions;
+    for( size_t i = 0 ; i < digits * in.size() ; ++i )
+    {
+        if( ( in[ i / digits ] >> ( i % digits ) ) & 1 )
+        {
+            positions.push_back( i );
+        }
+    }
+
+    if( popcount( rle.data(), rle.data() + rle.size() ) != positions.size() ||
+        popcount( rle.begin(), rle.end() ) != positions.size() )
+    {
+        return false;
+    }
+
+    for( size_t i = 0 ; i <= digits * in.size() + 9 ; i = i + 13 )
+    {
+        const auto expected = static_cast< uint64_t >( std::lower_bound( positions.begin(), positions.end(), i ) - positions.begin() );
+        if( rank( rle.data(), rle.data() + rle.size(), i ) != expected ||
+            rank( rle.begin(), rle.end(), i ) != expected )
+        {
+            return false;
+        }
+    }
+
+    for( size_t n = 0 ; n <= positions.size() ; n = n + 1 + n / 16 )
+    {
+        const auto expected = n < positions.size() ? positions[ n ] : digits * in.size();
+        if( select( rle.data(), rle.data() + rle.size(), n ) != expected ||
+            select( rle.begin(), rle.end(), n ) != expected )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void count_bits()
+{
+    for( uint32_t seed = 1 ; seed < 6 ; ++seed )
+    {
+        assert_true( same_counts( make_runs< uint8_t >( 2000 + seed, seed ) ) );
+        assert_true( same_counts( make_noise< uint8_t >( 500 + seed, seed ) ) );
+        assert_true( same_counts( make_runs< uint16_t >( 1000 + seed, seed ) ) );
+        assert_true( same_counts( make_runs< uint64_t >( 300 + seed, seed ) ) );
+    }
+
+    // Runs of zeros at the end are terminated with a stuffed bit that is not part of the data.
+    assert_true( same_counts( std::vector< uint8_t >{ 0xFF, 0x00, 0x00 } ) );
+    assert_true( same_counts( std::vector< uint8_t >{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 } ) );
+    assert_true( same_counts( std::vector< uint32_t >{ 0x00FFFFFFu, 0x00000000u } ) );
+    assert_true( same_counts( std::vector< uint8_t >() ) );
+
+    const brle8 rle[] = { 0xCC, 0x9C, 0x2A };
+
+    assert_true( popcount( std::begin( rle ), std::end( rle ) ) == 24u );
+    assert_true( rank( std::begin( rle ), std::end( rle ), 19 ) == 19u );
+    assert_true( select( std::begin( rle ), std::end( rle ), 20 ) == 57u );
+}
+
+template< typename T >
+static bool same_set_bits( const std::vector< T > & in )
+{
+    constexpr size_t digits = std::numeric_limits< T >::digits;
+
+    std::vector< brle8 > rle( 2 * in.size() * sizeof( T ) + 1 );
+    rle.resize( std::distance( rle.data(), encode( in.data(), in.data() + in.size(), rle.data() ) ) );
+
+    std::vector< uint64_t > expected;
+    for( size_t i = 0 ; i < digits * in.size() ; ++i )
+    {
+        if( ( in[ i / digits ] >> ( i % digits ) ) & 1 )
+        {
+            expected.push_back( i );
+        }
+    }
+
+    std::vector< uint64_t > contiguous;
+    std::vector< uint64_t > generic;
+
+    for_each_set_bit( rle.data(), rle.data() + rle.size(), [ & ]( uint64_t position ) { contiguous.push_back( position ); } );
+    for_each_set_bit( rle.begin(), rle.end(), [ & ]( uint64_t position ) { generic.push_back( position ); } );
+
+    return contiguous == expected && generic == expected;
+}
+
+static void set_bits()
+{
+    for( uint32_t seed = 1 ; seed < 6 ; ++seed )
+    {
+        assert_true( same_set_bits( make_runs< uint8_t >( 3000 + seed, seed ) ) );
+        assert_true( same_set_bits( make_noise< uint8_t >( 500 + seed, seed ) ) );
+        assert_true( same_set_bits( make_runs< uint32_t >( 1000 + seed, seed ) ) );
+    }
+
+    assert_true( same_set_bits( std::vector< uint8_t >{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } ) );
+    assert_true( same_set_bits( std::vector< uint64_t >( 100, ~uint64_t() ) ) );
+    assert_true( same_set_bits( std::vector< uint8_t >() ) );
+
+    struct counter
+    {
+        uint64_t n = 0;
+        void operator()( uint64_t ) { ++n; }
+    };
+
+    const brle8 rle[] = { 0xCC, 0x9C, 0x2A };
+
+    assert_true( for_each_set_bit( std::begin( rle ), std::end( rle ), counter() ).n == 24u );
+}
+
+// Expands the runs and literals that are passed to the visitor into bytes.
+struct run_collector
+{
+    std::vector< uint8_t > bytes;
+    uint64_t               word = 0;
+    int                    size = 0;
+    size_t                 runs = 0;
+
+    void push( bool bit )
+    {
+        word = word | static_cast< uint64_t >( bit ) << size;
+        if( ++size == 8 )
+        {
+            bytes.push_back( static_cast< uint8_t >( word ) );
+            word = 0;
+            size = 0;
+        }
+    }
+
+    void run( bool bit, uint64_t length )
+    {
+        ++runs;
+        for( uint64_t i = 0 ; i < length ; ++i )
+        {
+            push( bit );
+        }
+    }
+
+    void literal( uint8_t bits )
+    {
+        for( int i = 0 ; i < 7 ; ++i )
+        {
+            push( ( bits >> i ) & 1 );
+        }
+    }
+};
+
+static bool same_runs( const std::vector< uint8_t > & in )
+{
+    std::vector< brle8 > rle( 2 * in.size() + 1 );
+    rle.resize( std::distance( rle.data(), encode( in.data(), in.data() + in.size(), rle.data() ) ) );
+
+    const auto contiguous = decode_runs( rle.data(), rle.data() + rle.size(), run_collector() );
+    const auto generic    = decode_runs( rle.begin(), rle.end(), run_collector() );
+
+    return contiguous.bytes == in && generic.bytes == in && contiguous.runs <= generic.runs;
+}
+
+static void run_visitor()
+{
+    for( uint32_t seed = 1 ; seed < 6 ; ++seed )
+    {
+        assert_true( same_runs( make_runs< uint8_t >( 3000 + seed, seed ) ) );
+        assert_true( same_runs( make_noise< uint8_t >( 500 + seed, seed ) ) );
+    }
+
+    const brle8 rle[]     = { 0xCC, 0x9C, 0x2A };
+    const brle8 max_run[] = { 0xFF, 0xFF, 0xFF, 0x80 };
+
+    assert_true( decode_runs( std::begin( rle ), std::end( rle ), run_collector() ).runs == 4u );
+    assert_true( decode_runs( std::begin( max_run ), std::end( max_run ), run_collector() ).runs == 3u );
+    assert_true( decode_runs( static_cast< const brle8 * >( max_run ), std::end( max_run ), run_collector() ).runs == 3u );
+}
+
+// Mixes push, push_bits and push_run on one encoder and compares the result with encoding the same bits as bytes.
+template< typename T >
+static bool same_run_encoding( uint32_t seed, const uint32_t max_run )
+{
+    constexpr int digits = std::numeric_limits< T >::digits;
+
+    std::vector< bool >  bits;
+    std::vector< brle8 > rle;
+
+    encoder< T, std::back_insert_iterator< std::vector< brle8 > > > e( std::back_inserter( rle ) );
+    for( int i = 0 ; i < 300 ; ++i )
+    {
+        seed = seed * 1103515245u + 12345u;
+
+        const auto value = static_cast< T >( static_cast< uint64_t >( seed ) << 32 | ( seed * 2654435761u ) );
+        switch( ( seed >> 8 ) % 3u )
+        {
+        case 0:
+            e.push( value );
+            for( int b = 0 ; b < digits ; ++b )
+            {
+                bits.push_back( ( value >> b ) & 1 );
+            }
+            break;
+
+        case 1:
+        {
+            const auto nbits = static_cast< int >( ( seed >> 12 ) % ( digits + 1u ) );
+            e.push_bits( value, nbits );
+            for( int b = 0 ; b < nbits ; ++b )
+            {
+                bits.push_back( ( value >> b ) & 1 );
+            }
+            break;
+        }
+
+        default:
+        {
+            const bool bit   = ( seed >> 20 ) & 1;
+            const auto count = ( seed >> 12 ) % max_run;
+            e.push_run( bit, count );
+            bits.insert( bits.end(), count, bit );
+            break;
+        }
+        }
+    }
+
+    const auto pad = static_cast< int >( ( 8 - bits.size() % 8 ) % 8 );
+    e.push_bits( T(), pad );
+    bits.insert( bits.end(), pad, false );
+    e.flush();
+
+    std::vector< uint8_t > bytes( bits.size() / 8 );
+    for( size_t i = 0 ; i < bits.size() ; ++i )
+    {
+        bytes[ i / 8 ] = static_cast< uint8_t >( bytes[ i / 8 ] | bits[ i ] << ( i % 8 ) );
+    }
+
+    std::vector< brle8 > expected( 2 * bytes.size() + 1 );
+    expected.resize( std::distance( expected.data(), encode( bytes.data(), bytes.data() + bytes.size(), expected.data() ) ) );
+
+    return rle == expected;
+}
+
+static void encode_runs()
+{
+    for( uint32_t seed = 1 ; seed < 20 ; ++seed )
+    {
+        assert_true( same_run_encoding< uint8_t >( seed, 40 ) );
+        assert_true( same_run_encoding< uint8_t >( seed, 1000 ) );
+        assert_true( same_run_encoding< uint16_t >( seed, 100 ) );
+        assert_true( same_run_encoding< uint32_t >( seed, 300 ) );
+        assert_true( same_run_encoding< uint64_t >( seed, 5000 ) );
+    }
+
+    std::vector< brle8 > rle;
+    {
+        encoder< uint32_t, std::back_insert_iterator< std::vector< brle8 > > > e( std::back_inserter( rle ) );
+        e.push_bits( 0x5, 3 );
+        e.push_run( false, 71 * 1000000 - 3 );
+        e.push_run( true, 8 );
+    }
+
+    assert_true( rle.size() == 1000002u );
+    assert_true( decoded_size( rle.begin(), rle.end() ) == ( 71 * 1000000 + 8 ) / 8 );
+}
+
+template< typename Op, typename Combine >
+static bool same_combination( const std::vector< uint8_t > & a, const std::vector< uint8_t > & b, Op op, Combine combine )
+{
+    const auto size = std::min( a.size(), b.size() );
+
+    std::vector< uint8_t > combined( size );
+    std::transform( a.begin(), a.begin() + size, b.begin(), combined.begin(), op );
+
+    std::vector< brle8 > expected( 2 * size + 1 );
+    expected.resize( std::distance( expected.data(), encode( combined.data(), combined.data() + size, expected.data() ) ) );
+
+    std::vector< brle8 > rle_a( 2 * a.size() + 1 );
+    std::vector< brle8 > rle_b( 2 * b.size() + 1 );
+    rle_a.resize( std::distance( rle_a.data(), encode( a.data(), a.data() + a.size(), rle_a.data() ) ) );
+    rle_b.resize( std::distance( rle_b.data(), encode( b.data(), b.data() + b.size(), rle_b.data() ) ) );
+
+    std::vector< brle8 > contiguous( expected.size() + 16 );
+    std::vector< brle8 > generic;
+
+    const auto end = combine( rle_a.data(), rle_a.data() + rle_a.size(), rle_b.data(), rle_b.data() + rle_b.size(), contiguous.data() );
+    combine( rle_a.begin(), rle_a.end(), rle_b.begin(), rle_b.end(), std::back_inserter( generic ) );
+
+    return std::equal( expected.begin(), expected.end(), contiguous.data(), end ) && generic == expected;
+}
+
+static bool same_combinations( const std::vector< uint8_t > & a, const std::vector< uint8_t > & b )
+{
+    return same_combination( a, b, []( uint8_t x, uint8_t y ) { return static_cast< uint8_t >( x & y ); },
+                                   []( auto... args ) { return bitwise_and( args... ); } ) &&
+           same_combination( a, b, []( uint8_t x, uint8_t y ) { return static_cast< uint8_t >( x | y ); },
+                                   []( auto... args ) { return bitwise_or( args... ); } ) &&
+           same_combination( a, b, []( uint8_t x, uint8_t y ) { return static_cast< uint8_t >( x ^ y ); },
+                                   []( auto... args ) { return bitwise_xor( args... ); } ) &&
+           same_combination( a, b, []( uint8_t x, uint8_t y ) { return static_cast< uint8_t >( x & ~y ); },
+                                   []( auto... args ) { return bitwise_andnot( args... ); } );
+}
+
+static void logical_operations()
+{
+    for( uint32_t seed = 1 ; seed < 6 ; ++seed )
+    {
+        const auto runs  = make_runs< uint8_t >( 5000, seed );
+        const auto other = make_runs< uint8_t >( 5000, seed + 100 );
+        const auto noise = make_noise< uint8_t >( 5000, seed );
+
+        assert_true( same_combinations( runs, other ) );
+        assert_true( same_combinations( runs, noise ) );
+        assert_true( same_combinations( noise, runs ) );
+        assert_true( same_combinations( runs, runs ) );
+        assert_true( same_combinations( runs, make_runs< uint8_t >( 3001, seed + 200 ) ) );
+        assert_true( same_combinations( make_noise< uint8_t >( 1001, seed ), other ) );
+    }
+
+    const std::vector< uint8_t > zeros( 4000, 0x00 );
+    const std::vector< uint8_t > ones( 4000, 0xFF );
+    const auto                   runs = make_runs< uint8_t >( 4000, 42 );
+
+    assert_true( same_combinations( zeros, runs ) );
+    assert_true( same_combinations( runs, ones ) );
+    assert_true( same_combinations( zeros, ones ) );
+    assert_true( same_combinations( ones, ones ) );
+    assert_true( same_combinations( zeros, std::vector< uint8_t >() ) );
+}
+
+template< typename T >
+static bool same_parallel_encoding( const std::vector< T > & in, const unsigned threads )
+{
+    std::vector< brle8 > expected( 2 * in.size() * sizeof( T ) + 1 );
+    std::vector< brle8 > parallel( expected.size() );
+
+    const auto expected_end = encode( in.data(), in.data() + in.size(), expected.data() );
+    const auto parallel_end = parallel_encode( in.data(), in.data() + in.size(), parallel.data(), threads );
+
+    return std::equal( expected.data(), expected_end, parallel.data(), parallel_end );
+}
+
+static void parallel_encoding()
+{
+    for( uint32_t seed = 1 ; seed < 4 ; ++seed )
+    {
+        for( unsigned threads = 1 ; threads <= 8 ; threads = threads * 2 + 1 )
+        {
+            assert_true( same_parallel_encoding( make_runs< uint8_t >( 200000 + seed, seed ), threads ) );
+            assert_true( same_parallel_encoding( make_noise< uint8_t >( 200000 + seed, seed ), threads ) );
+            assert_true( same_parallel_encoding( make_runs< uint16_t >( 100000 + seed, seed ), threads ) );
+            assert_true( same_parallel_encoding( make_noise< uint32_t >( 50000 + seed, seed ), threads ) );
+            assert_true( same_parallel_encoding( make_runs< uint64_t >( 30000 + seed, seed ), threads ) );
+        }
+    }
+
+    // Data without positions to split at is encoded in fewer chunks.
+    assert_true( same_parallel_encoding( std::vector< uint8_t >( 1000000, 0x00 ), 4 ) );
+    assert_true( same_parallel_encoding( std::vector< uint64_t >( 100000, 0xAAAAAAAAAAAAAAAAu ), 4 ) );
+    assert_true( same_parallel_encoding( std::vector< uint8_t >( 10, 0xFF ), 4 ) );
+    assert_true( same_parallel_encoding( std::vector< uint8_t >(), 4 ) );
+}
+
+template< typename T >
+static bool same_parallel_decoding( const std::vector< brle8 > & rle, const unsigned threads )
+{
+    std::vector< T > expected( decoded_size< T >( rle.data(), rle.data() + rle.size() ) + 1 );
+    std::vector< T > parallel( expected.size(), T( 0x5A ) );
+
+    const auto expected_end = decode( rle.data(), rle.data() + rle.size(), expected.data() );
+    const auto parallel_end = parallel_decode( rle.data(), rle.data() + rle.size(), parallel.data(), threads );
+
+    return std::equal( expected.data(), expected_end, parallel.data(), parallel_end ) && *parallel_end == T( 0x5A );
+}
+
+template< typename T >
+static bool same_parallel_decodings( const std::vector< T > & in )
+{
+    std::vector< brle8 > rle( 2 * in.size() * sizeof( T ) + 1 );
+    rle.resize( std::distance( rle.data(), encode( in.data(), in.data() + in.size(), rle.data() ) ) );
+
+    for( unsigned threads = 1 ; threads <= 8 ; threads = threads * 2 + 1 )
+    {
+        if( !same_parallel_decoding< uint8_t >( rle, threads ) || !same_parallel_decoding< uint16_t >( rle, threads ) ||
+            !same_parallel_decoding< uint32_t >( rle, threads ) || !same_parallel_decoding< uint64_t >( rle, threads ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void parallel_decoding()
+{
+    for( uint32_t seed = 1 ; seed < 4 ; ++seed )
+    {
+        assert_true( same_parallel_decodings( make_runs< uint8_t >( 400000 + seed, seed ) ) );
+        assert_true( same_parallel_decodings( make_noise< uint8_t >( 400000 + seed, seed ) ) );
+        assert_true( same_parallel_decodings( make_runs< uint64_t >( 300000 + seed, seed ) ) );
+    }
+
+    assert_true( same_parallel_decodings( std::vector< uint8_t >( 10000000, 0x00 ) ) );
+    assert_true( same_parallel_decodings( std::vector< uint8_t >( 10, 0xFF ) ) );
+    assert_true( same_parallel_decodings( std::vector< uint8_t >() ) );
+}
+
+static bool frame_roundtrip( const std::vector< uint8_t > & in, const uint32_t chunk_size )
+{
+    std::vector< uint8_t > frame;
+    encode_frame( in.data(), in.data() + in.size(), std::back_inserter( frame ), chunk_size );
+
+    const frame_reader reader( frame.data(), frame.data() + frame.size() );
+    if( !reader.valid() || reader.original_size() != in.size() )
+    {
+        return false;
+    }
+
+    // Decode the chunks in reverse order to show that they do not depend on each other.
+    std::vector< uint8_t > out( in.size() + 1, 0x5A );
+    for( auto i = reader.chunk_count() ; i > 0 ; --i )
+    {
+        if( !decode_chunk( reader.chunk( i - 1 ), out.data() ) )
+        {
+            return false;
+        }
+    }
+
+    std::vector< uint8_t > all( in.size() + 1, 0x5A );
+    const auto             end = decode_frame( frame.data(), frame.data() + frame.size(), all.data() );
+
+    return end == all.data() + in.size() && std::equal( in.begin(), in.end(), out.begin() ) && out.back() == 0x5A && out == all;
+}
+
+static void frames()
+{
+    for( uint32_t seed = 1 ; seed < 4 ; ++seed )
+    {
+        const uint32_t chunk_sizes[] = { 1, 7, 1000, 1u << 20 };
+        for( const auto chunk_size : chunk_sizes )
+        {
+            assert_true( frame_roundtrip( make_runs< uint8_t >( 5000 + seed, seed ), chunk_size ) );
+            assert_true( frame_roundtrip( make_noise< uint8_t >( 3000, seed ), chunk_size ) );
+        }
+    }
+    assert_true( frame_roundtrip( std::vector< uint8_t >(), 100 ) );
+
+    const auto             in = make_runs< uint8_t >( 5000, 1 );
+    std::vector< uint8_t > frame;
+    encode_frame( in.data(), in.data() + in.size(), std::back_inserter( frame ), 1000 );
+
+    std::vector< uint8_t > out( in.size() );
+    assert_true( frame_reader( frame.data(), frame.data() + frame.size() ).chunk_count() == 5u );
+    assert_false( frame_reader( frame.data(), frame.data() + frame.size() - 1 ).valid() );
+    assert_false( frame_reader( frame.data(), frame.data() + 23 ).valid() );
+    assert_true( decode_frame( frame.data(), frame.data() + frame.size() - 1, out.data() ) == nullptr );
+
+    frame[ 24 ] = frame[ 24 ] + 1; // Decoded size of the first chunk
+    assert_false( frame_reader( frame.data(), frame.data() + frame.size() ).valid() );
+    frame[ 24 ] = frame[ 24 ] - 1;
+    frame[ 28 ] = frame[ 28 ] - 1; // Encoded size of the first chunk
+    assert_true( frame_reader( frame.data(), frame.data() + frame.size() ).valid() );
+    assert_true( decode_frame( frame.data(), frame.data() + frame.size(), out.data() ) == nullptr );
+
+    // The encoded size of a chunk of the maximum size must fit in its 32-bit table entry.
+    constexpr uint64_t max_entry = std::numeric_limits< uint32_t >::max();
+    assert_true( static_cast< uint64_t >( detail::max_blocks( 8 * static_cast< std::ptrdiff_t >( max_frame_chunk_size ) ) ) <= max_entry );
+    assert_true( static_cast< uint64_t >( detail::max_blocks( 8 * static_cast< std::ptrdiff_t >( max_frame_chunk_size + 1 ) ) ) > max_entry );
+
+    frame.clear();
+    encode_frame( in.data(), in.data() + in.size(), std::back_inserter( frame ), std::numeric_limits< uint32_t >::max() );
+    assert_true( detail::read_le( frame.data() + 16, 4 ) == max_frame_chunk_size );
+    assert_true( frame_roundtrip( in, std::numeric_limits< uint32_t >::max() ) );
+
+    frame[ 16 ] = 0xFF; frame[ 17 ] = 0xFF; frame[ 18 ] = 0xFF; frame[ 19 ] = 0xFF; // Chunk size beyond the maximum
+    assert_false( frame_reader( frame.data(), frame.data() + frame.size() ).valid() );
+
+    // The chunk size is raised when the number of chunks does not fit in its 32-bit header field.
+    assert_true( detail::frame_chunk_size( max_entry, 1 ) == 1u );
+    assert_true( detail::frame_chunk_size( max_entry + 1, 1 ) == 2u );
+    assert_true( detail::frame_chunk_size( 5 * max_entry, 3 ) == 5u );
+    assert_true( detail::frame_chunk_size( 5 * max_entry, 6 ) == 6u );
+    assert_true( detail::frame_chunk_size( uint64_t( max_frame_chunk_size ) * max_entry, 1 ) == max_frame_chunk_size );
+}
+
 static void readme_examples()
 {
     {
@@ -199,6 +1025,19 @@ int main()
     encode_decode_uint32();
     encode_decode_uint64();
     bitmap_header();
+    encode_contiguous();
+    decode_table_driven();
+    size_functions();
+    bounded_output();
+    random_access();
+    count_bits();
+    set_bits();
+    run_visitor();
+    encode_runs();
+    logical_operations();
+    parallel_encoding();
+    parallel_decoding();
+    frames();
     readme_examples();
 
     std::cout << "Total tests: " << total_checks << ", Tests failed: " << failed_checks << '\n';
@@ -21,14 +21,51 @@
 // SOFTWARE.
 
 #include <brle.h>
-#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <cstdarg>
 #include <cerrno>
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+ #define BRLE_HAS_MMAP 1
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#else
+ #define BRLE_HAS_MMAP 0
+#endif
+
+#if defined( __linux__ ) && __has_include( <linux/io_uring.h> )
+ #define BRLE_HAS_IO_URING 1
+ #include <linux/io_uring.h>
+ #include <sys/syscall.h>
+ #include <sys/uio.h>
+#else
+ #define BRLE_HAS_IO_URING 0
+#endif
+
+#if BRLE_HAS_MMAP && defined( SEEK_DATA ) && defined( SEEK_HOLE )
+ #define BRLE_HAS_SEEK_HOLE 1
+#else
+ #define BRLE_HAS_SEEK_HOLE 0
+#endif
+
+#if BRLE_HAS_MMAP && !defined( __APPLE__ )
+ #define BRLE_HAS_FALLOCATE 1
+#else
+ #define BRLE_HAS_FALLOCATE 0
+#endif
 
 static void brle_argument_error( const char * const format, ... )
 {
@@ -44,10 +81,23 @@ static void brle_argument_error( const char * const format, ... )
     std::exit( EINVAL );
 }
 
-static void brle_errno( const char * const prefix )
+// An error of a system or C library call with the value of errno and the prefix of its message.
+struct io_error
+{
+    const char * prefix;
+    int          error;
+};
+
+[[noreturn]] static void brle_errno( const char * const prefix )
+{
+    throw io_error{ prefix, errno };
+}
+
+[[noreturn]] static void exit_on_error( const io_error & error )
 {
-    std::perror( prefix );
-    std::exit( errno );
+    errno = error.error;
+    std::perror( error.prefix );
+    std::exit( error.error );
 }
 
 
@@ -103,117 +153,137 @@ private:
     const char *        opt;
 };
 
-template< typename T >
-struct binary_input_file_iterator
+// A buffer for file I/O that is aligned to the page size of most systems.
+struct io_buffer
 {
-    using difference_type   = std::ptrdiff_t;
-    using value_type        = T;
-    using pointer           = T *;
-    using reference         = T &;
-    using iterator_category = std::input_iterator_tag;
+    static constexpr std::size_t alignment = 4096;
+
+    explicit io_buffer( const std::size_t size )
+        : data( static_cast< uint8_t * >( ::operator new[]( size, std::align_val_t( alignment ) ) ) )
+        , size( size )
+    {}
+
+    io_buffer( const io_buffer & )             = delete;
+    io_buffer & operator=( const io_buffer & ) = delete;
 
-    binary_input_file_iterator( std::FILE * file = nullptr )
-        : file( file )
+    ~io_buffer()
     {
-        if( file )
-        {
-            next();
-        }
+        ::operator delete[]( data, std::align_val_t( alignment ) );
     }
 
-    bool operator==( const binary_input_file_iterator & other ) const
-    {
-        if( file == nullptr || other.file == nullptr )
-        {
-            return file == other.file;
-        }
+    uint8_t * const   data;
+    const std::size_t size;
+};
 
-        return file == other.file && std::ftell( file ) == std::ftell( other.file );
-    }
+static constexpr std::size_t buffer_size = 1 << 20;
+
+// The buffers of the encode and decode functions, they are reused for all the files of a batch.
+struct codec_buffers
+{
+    io_buffer input{ buffer_size };
+    io_buffer output{ buffer_size * 9 };    // A block decodes to at most 71 bits.
+};
 
-    bool operator!=( const binary_input_file_iterator & other ) const
+// Reads up to 'size' bytes. Less bytes are only returned at the end of the input.
+static std::size_t read( std::FILE * const file, uint8_t * const data, const std::size_t size )
+{
+    const auto n = std::fread( data, 1, size, file );
+    if( n < size && std::ferror( file ) )
     {
-        return !operator==( other );
+        brle_errno( "Input" );
     }
 
-    reference                    operator*()        { return value; }
-    const reference              operator*() const  { return value; }
-    binary_input_file_iterator * operator->() const { return &value; }
-    binary_input_file_iterator & operator++()       { next(); return *this; }
-    binary_input_file_iterator   operator++( int )  { auto it = *this; next(); return it; }
+    return n;
+}
 
-private:
-    std::FILE * file  = nullptr;
-    T           value = T();
+static void write( std::FILE * const file, const uint8_t * const data, const std::size_t size )
+{
+    if( std::fwrite( data, 1, size, file ) != size )
+    {
+        brle_errno( "Output" );
+    }
+}
+
+static void write_zeros( std::FILE * const file, std::size_t size )
+{
+    static const uint8_t zeros[ 4096 ] = {};
 
-    void next()
+    for( auto n = std::min( size, sizeof( zeros ) ) ; size > 0 ; n = std::min( size, sizeof( zeros ) ) )
     {
-        assert( file != nullptr );
+        write( file, zeros, n );
+        size = size - n;
+    }
+}
 
-        if( std::fread( &value, sizeof( T ), 1, file ) )
-        {
-            return;
-        }
-        else if( std::feof( file ) )
-        {
-            file = nullptr;
-            return;
-        }
+// Returns the number of RLE values from the start that decode to a whole number of bytes, as many as possible.
+static std::size_t byte_aligned_blocks( const pg::brle::brle8 * const first, const pg::brle::brle8 * const last )
+{
+    unsigned bits    = 0;
+    auto     aligned = first;
+
+    for( auto it = first ; it != last ; )
+    {
+        const pg::brle::brle8 rle   = *it++;
+        const unsigned        count = ( rle & 0x3Fu ) + 8u;
 
-        if( std::ferror( file ) )
+        bits = bits + ( rle & 0x80u ? count + ( count != 71u ) : 7u );
+        if( bits % 8u == 0 )
         {
-            brle_errno( "Input" );
+            aligned = it;
         }
     }
-};
 
-template< typename T >
-struct binary_output_file_iterator
+    return static_cast< std::size_t >( aligned - first );
+}
+
+// Zero runs that decode to at least this number of bytes are skipped in the output of a sparse decode.
+static constexpr std::size_t sparse_gap = 4096;
+
+// Splits RLE data that starts at a byte boundary into parts that are passed to 'data' and long runs of zeros between them
+// whose size in bytes is passed to 'gap'. Each part starts and ends at a byte boundary of the decoded data.
+template< typename Data, typename Gap >
+static void split_zero_runs( const pg::brle::brle8 * const first, const pg::brle::brle8 * const last, Data data, Gap gap )
 {
-    using difference_type   = std::ptrdiff_t;
-    using value_type        = void;
-    using pointer           = void;
-    using reference         = void;
-    using iterator_category = std::output_iterator_tag;
+    constexpr pg::brle::brle8 max_zeros = 0xBF;    // A zeros block with the maximum count of 71 bits
 
-    binary_output_file_iterator( std::FILE * file = nullptr )
-        : file( file )
-    {}
+    uint64_t bits = 0;
+    auto     part = first;
 
-    binary_output_file_iterator& operator=( T value )
+    for( auto it = first ; it != last ; )
     {
-        assert( file );
-
-        if( std::fwrite( &value, sizeof( T ), 1, file ) != 1 )
+        const pg::brle::brle8 rle = *it;
+        if( rle != max_zeros )
         {
+            const unsigned count = ( rle & 0x3Fu ) + 8u;
 
+            bits = bits + ( rle & 0x80u ? count + ( count != 71u ) : 7u );
+            ++it;
+            continue;
         }
 
-        return *this;
-    }
+        const auto     run_last = std::find_if( it, last, []( const pg::brle::brle8 r ){ return r != max_zeros; } );
+        const uint64_t blocks   = static_cast< uint64_t >( run_last - it );
 
-    bool operator==( const binary_output_file_iterator & other ) const
-    {
-        if( file == nullptr || other.file == nullptr )
+        // 71 equals -1 modulo 8, so after 'n' blocks of 71 bits the position is at a byte boundary when 'n' equals 'bits' modulo 8.
+        const uint64_t gap_first = bits % 8u;
+        if( blocks > gap_first )
         {
-            return file == other.file;
+            const uint64_t gap_last  = blocks - ( blocks - gap_first ) % 8u;
+            const uint64_t gap_bytes = ( gap_last - gap_first ) * 71u / 8u;
+            if( gap_bytes >= sparse_gap )
+            {
+                data( part, it + gap_first );
+                gap( static_cast< std::size_t >( gap_bytes ) );
+                part = it + gap_last;
+            }
         }
 
-        return file == other.file && std::ftell( file ) == std::ftell( other.file );
-    }
-
-    bool operator!=( const binary_output_file_iterator & other ) const
-    {
-        return !operator==( other );
+        bits = bits + blocks * 71u;
+        it   = run_last;
     }
 
-    binary_output_file_iterator & operator*()       { return *this; }
-    binary_output_file_iterator & operator++()      { return *this; }
-    binary_output_file_iterator   operator++( int ) { return *this; }
-
-private:
-    std::FILE * const file = nullptr;
-};
+    data( part, last );
+}
 
 
 static void print_help()
@@ -244,6 +314,14 @@ static void print_help()
         "OPTIONS\n"
         "    -e  Encode input.\n"
         "    -d  Decode input.\n"
+        "    -p  Read, encode or decode and write on separate threads.\n"
+        "    -u  Like 'p' and read and write files with io_uring when available.\n"
+        "    -b  Benchmark the encoding and decoding of the input in memory.\n"
+        "    -n  The number of iterations of a benchmark, the default is 20.\n"
+        "    -s  Benchmark with the uint16_t, uint32_t and uint64_t data types too.\n"
+        "    -j  Encode or decode a batch of files with the given number of threads.\n"
+        "    -l  Add the files from a list to the batch, one input per line and\n"
+        "        optionally a tab followed by the output.\n"
         "    -h  Shows this help.\n"
         "\n"
         "USAGE\n"
@@ -270,97 +348,1499 @@ static void print_help()
         "\n"
         "    Expand from from input file to standard output\n"
         "\n"
-        "        brle -d file -\n";
+        "        brle -d file -\n"
+        "\n"
+        "    Encode a batch of files with 4 threads to 'file1.rle' and 'file2.rle'.\n"
+        "\n"
+        "        brle -e -j 4 file1 file2\n"
+        "\n"
+        "    Decode the files that are listed in the standard input.\n"
+        "\n"
+        "        ls *.rle | brle -d -l -\n";
 
     std::puts( help );
 }
 
-static void encode( std::FILE * const in, std::FILE * const out )
+#if BRLE_HAS_MMAP
+
+// A memory mapping of a whole regular file.
+// 'data' is a null pointer when the file could not be mapped.
+struct mapped_file
+{
+    mapped_file( std::FILE * const file, const std::size_t size, const bool writable )
+        : size( size )
+    {
+        const int  protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void * const address  = size ? mmap( nullptr, size, protection, MAP_SHARED, fileno( file ), 0 ) : MAP_FAILED;
+
+        data = address != MAP_FAILED ? static_cast< uint8_t * >( address ) : nullptr;
+    }
+
+    mapped_file( const mapped_file & )             = delete;
+    mapped_file & operator=( const mapped_file & ) = delete;
+
+    ~mapped_file()
+    {
+        if( data )
+        {
+            munmap( data, size );
+        }
+    }
+
+    uint8_t *         data = nullptr;
+    const std::size_t size;
+};
+
+static bool is_regular_file( std::FILE * const file, std::size_t & size )
+{
+    struct stat status;
+    if( fstat( fileno( file ), &status ) != 0 || !S_ISREG( status.st_mode ) )
+    {
+        return false;
+    }
+
+    size = static_cast< std::size_t >( status.st_size );
+
+    return true;
+}
+
+// Whether the writes to a file always go to its end, seeking does not change where the next write lands.
+static bool is_appending( std::FILE * const file )
 {
-    auto in_begin  = binary_input_file_iterator< uint8_t >( in );
-    auto in_end    = binary_input_file_iterator< uint8_t >();
-    auto out_begin = binary_output_file_iterator< pg::brle::brle8 >( out );
+    const int flags = fcntl( fileno( file ), F_GETFL );
 
-    pg::brle::encode( in_begin, in_end, out_begin );
+    return flags < 0 || ( flags & O_APPEND );
 }
 
-static void decode( std::FILE * const in, std::FILE * const out )
+// Reserves the blocks of a file for the data that 'first' to 'last' decode to, the long runs of zeros remain holes.
+// Writing a mapping of a file whose blocks are not reserved raises SIGBUS when the disk is full.
+// Returns false when the blocks could not be reserved, the file is truncated back to 'size' then.
+static bool reserve_blocks( std::FILE * const file, const std::size_t size, const pg::brle::brle8 * const first, const pg::brle::brle8 * const last )
 {
-    auto in_begin  = binary_input_file_iterator< pg::brle::brle8 >( in );
-    auto in_end    = binary_input_file_iterator< pg::brle::brle8 >();
-    auto out_begin = binary_output_file_iterator< uint8_t >( out );
+#if BRLE_HAS_FALLOCATE
+    off_t offset = 0;
+    int   error  = 0;
+
+    split_zero_runs( first, last,
+                     [ & ]( const pg::brle::brle8 * const f, const pg::brle::brle8 * const l )
+                     {
+                         const auto bytes = static_cast< off_t >( pg::brle::decoded_size( f, l ) );
+                         if( error == 0 && bytes > 0 )
+                         {
+                             error = posix_fallocate( fileno( file ), offset, bytes );
+                         }
+                         offset = offset + bytes;
+                     },
+                     [ & ]( const std::size_t bytes ){ offset = offset + static_cast< off_t >( bytes ); } );
 
-    pg::brle::decode< binary_input_file_iterator< pg::brle::brle8 >,
-                      binary_output_file_iterator< uint8_t >,
-                      uint8_t >
-                    ( in_begin, in_end, out_begin );
+    if( error == 0 )
+    {
+        return true;
+    }
+#else
+    static_cast< void >( first );
+    static_cast< void >( last );
+#endif
+    if( ftruncate( fileno( file ), static_cast< off_t >( size ) ) != 0 )
+    {
+        brle_errno( "Output" );
+    }
+
+    return false;
 }
 
+#endif
 
-int main( const int argc, const char * argv[] )
+static void encode_range( pg::brle::encoder< uint8_t, pg::brle::brle8 * > & e, const uint8_t * first, const uint8_t * const last,
+                          io_buffer & output, std::FILE * const out )
+{
+    while( first != last )
+    {
+        first = pg::brle::encode_some( e, first, last, output.data + output.size );
+        write( out, output.data, e.get_output() - output.data );
+        e.set_output( output.data );
+    }
+}
+
+// Encodes 'bits' zeros in parts that fit in the output buffer.
+static void encode_zeros( pg::brle::encoder< uint8_t, pg::brle::brle8 * > & e, uint64_t bits, io_buffer & output, std::FILE * const out )
 {
-    enum transformation : char { encode_ = 'e', decode_ = 'd' };
+    // Reserve a few blocks for the bits that are pending in the encoder.
+    const uint64_t max_bits = ( output.size - 16u ) * 71u;
+
+    while( bits > 0 )
+    {
+        const auto count = std::min( bits, max_bits );
+
+        write( out, output.data, e.push_run( false, count ) - output.data );
+        e.set_output( output.data );
+        bits = bits - count;
+    }
+}
+
+#if BRLE_HAS_SEEK_HOLE
 
-    transformation   direction = transformation::encode_;
-    std::string_view input;
-    std::string_view output;
+// Encodes a mapped file of which the holes are encoded as zeros without reading them.
+// The whole file is treated as data when the file system does not report its holes.
+static void encode_sparse( pg::brle::encoder< uint8_t, pg::brle::brle8 * > & e, std::FILE * const in, const uint8_t * const data,
+                           const off_t size, io_buffer & output, std::FILE * const out )
+{
+    const int fd = fileno( in );
 
+    for( off_t offset = 0 ; offset < size ; )
     {
-        options opts( argc, argv );
-        for( char opt = opts.read_option() ; opt != '\0' ; opt = opts.read_option() )
+        off_t data_first = lseek( fd, offset, SEEK_DATA );
+        if( data_first < 0 )
         {
-            switch( opt )
+            data_first = errno == ENXIO ? size : offset;
+        }
+        data_first = std::min( data_first, size );
+
+        off_t data_last = data_first < size ? lseek( fd, data_first, SEEK_HOLE ) : size;
+        if( data_last < 0 || data_last > size )
+        {
+            data_last = size;
+        }
+
+        encode_zeros( e, static_cast< uint64_t >( data_first - offset ) * 8u, output, out );
+        encode_range( e, data + data_first, data + data_last, output, out );
+
+        offset = data_last;
+    }
+}
+
+#endif
+
+// 'named_input' tells that the utility opened the input itself by its name, only such an input is mapped from its start.
+// Another input, like a standard input that was partly read before, is read from its current position.
+static void encode( std::FILE * const in, std::FILE * const out, codec_buffers & buffers, const bool named_input )
+{
+    io_buffer & output = buffers.output;
+
+    pg::brle::encoder< uint8_t, pg::brle::brle8 * > e( output.data );
+
+#if BRLE_HAS_MMAP
+    std::size_t file_size = 0;
+    if( named_input && is_regular_file( in, file_size ) )
+    {
+        const mapped_file input( in, file_size, false );
+        if( input.data )
+        {
+            madvise( input.data, file_size, MADV_SEQUENTIAL );
+#if BRLE_HAS_SEEK_HOLE
+            encode_sparse( e, in, input.data, static_cast< off_t >( file_size ), output, out );
+#else
+            encode_range( e, input.data, input.data + file_size, output, out );
+#endif
+            write( out, output.data, e.flush() - output.data );
+            return;
+        }
+    }
+#endif
+
+    io_buffer & input = buffers.input;
+
+    for( auto size = read( in, input.data, input.size ) ; size > 0 ; size = read( in, input.data, input.size ) )
+    {
+        encode_range( e, input.data, input.data + size, output, out );
+    }
+
+    write( out, output.data, e.flush() - output.data );
+}
+
+// Decodes with a decoder that keeps the bits of partial values until the next input is provided.
+static void decode_partial( pg::brle::decoder< uint8_t, const pg::brle::brle8 * > & d, const pg::brle::brle8 * const first,
+                            const pg::brle::brle8 * const last, io_buffer & output, std::FILE * const out )
+{
+    d.set_input( first, last );
+    for( auto end = pg::brle::decode_some( d, output.data, output.data + output.size ) ; end != output.data ;
+              end = pg::brle::decode_some( d, output.data, output.data + output.size ) )
+    {
+        write( out, output.data, end - output.data );
+    }
+}
+
+// Decodes blocks that are all in memory and writes the result in parts of at most 9 MiB.
+static void decode_range( const pg::brle::brle8 * first, const pg::brle::brle8 * const last, io_buffer & output, std::FILE * const out )
+{
+    while( first != last )
+    {
+        const auto chunk_last = static_cast< std::size_t >( last - first ) > buffer_size ? first + buffer_size : last;
+        const auto blocks     = chunk_last == last ? chunk_last - first : byte_aligned_blocks( first, chunk_last );
+        if( blocks == 0 )
+        {
+            pg::brle::decoder< uint8_t, const pg::brle::brle8 * > d;
+            decode_partial( d, first, last, output, out );
+            return;
+        }
+
+        write( out, output.data, pg::brle::decode( first, first + blocks, output.data ) - output.data );
+        first = first + blocks;
+    }
+}
+
+// 'named_input' and 'named_output' tell that the utility opened the input and output itself by their names.
+// Only those are memory mapped, see encode.
+static void decode( std::FILE * const in, std::FILE * const out, codec_buffers & buffers, const bool named_input, const bool named_output )
+{
+    io_buffer & output = buffers.output;
+
+#if BRLE_HAS_MMAP
+    std::size_t file_size = 0;
+    if( named_input && is_regular_file( in, file_size ) )
+    {
+        const mapped_file input( in, file_size, false );
+        if( input.data )
+        {
+            const auto first = input.data;
+            const auto last  = input.data + file_size;
+
+            madvise( input.data, file_size, MADV_SEQUENTIAL );
+
+            // Decode straight into the output file when it can be mapped too. That is only done for an output that starts at
+            // the beginning of the file and does not append, otherwise the mapping would not match where the data should go.
+            std::size_t out_size = 0;
+            if( named_output && is_regular_file( out, out_size ) && !is_appending( out ) && lseek( fileno( out ), 0, SEEK_CUR ) == 0 )
             {
-            case 'e':
-                direction = transformation::encode_;
-                break;
-                
-            case 'd':
-                direction = transformation::decode_;
-                break;
+                // The file is only extended after it has been mapped so that a failed mapping leaves it untouched.
+                // It is written with stdio when its blocks cannot be reserved, which reports a full disk as an error.
+                const auto        decoded_size = pg::brle::decoded_size( first, last );
+                const mapped_file mapped_output( out, decoded_size, true );
+                if( ( mapped_output.data || decoded_size == 0 ) && reserve_blocks( out, out_size, first, last ) )
+                {
+                    if( ftruncate( fileno( out ), static_cast< off_t >( decoded_size ) ) != 0 )
+                    {
+                        brle_errno( "Output" );
+                    }
 
-            case 'h':
-                print_help();
-                break;
+                    // The gaps are not written so they remain holes in the output file.
+                    auto result = mapped_output.data;
+                    split_zero_runs( first, last,
+                                     [ & ]( const pg::brle::brle8 * const f, const pg::brle::brle8 * const l ){ result = pg::brle::decode( f, l, result ); },
+                                     [ & ]( const std::size_t bytes ){ result = result + bytes; } );
+                    return;
+                }
+            }
 
-            default:
-                brle_argument_error( "Unrecognized option '%c'.", opt );
+            decode_range( first, last, output, out );
+            return;
+        }
+    }
+#endif
+
+    io_buffer & input = buffers.input;
+
+    // Long runs of zeros are skipped with a seek when the output is a regular file that does not append.
+#if BRLE_HAS_MMAP
+    std::size_t out_size = 0;
+    const bool  sparse   = is_regular_file( out, out_size ) && !is_appending( out );
+#else
+    const bool  sparse   = false;
+#endif
+    std::size_t gap      = 0;
+
+    // The zeros are written when the seek does not move the position of the output by the size of the gap.
+    const auto skip_gap = [ & ]( const std::size_t keep )
+    {
+        if( gap > keep )
+        {
+            const auto bytes    = static_cast< long >( gap - keep );
+            const auto position = std::ftell( out );
+            if( position < 0 || std::fseek( out, bytes, SEEK_CUR ) != 0 || std::ftell( out ) != position + bytes )
+            {
+                if( position >= 0 && std::fseek( out, position, SEEK_SET ) != 0 )
+                {
+                    brle_errno( "Output" );
+                }
+
+                write_zeros( out, gap - keep );
+            }
+        }
+        gap = keep;
+    };
+
+    const auto decode_part = [ & ]( const pg::brle::brle8 * const first, const pg::brle::brle8 * const last )
+    {
+        const auto result = pg::brle::decode( first, last, output.data );
+        if( result != output.data )
+        {
+            skip_gap( 0 );
+            write( out, output.data, result - output.data );
+        }
+    };
+
+    // A trailing gap is closed with a zero byte to get the full output size.
+    const auto close_gap = [ & ]()
+    {
+        if( gap > 0 )
+        {
+            skip_gap( 1 );
+            write_zeros( out, 1 );
+        }
+    };
+
+    std::size_t size = 0;
+    for( bool end_of_input = false ; !end_of_input ; )
+    {
+        const auto n = read( in, input.data + size, input.size - size );
+
+        size         = size + n;
+        end_of_input = size < input.size;
+
+        // The blocks that do not complete a byte are kept for the next read.
+        const auto blocks = end_of_input ? size : byte_aligned_blocks( input.data, input.data + size );
+        if( blocks == 0 && !end_of_input )
+        {
+            skip_gap( 0 );
+
+            pg::brle::decoder< uint8_t, const pg::brle::brle8 * > d;
+            for( ; size > 0 ; size = read( in, input.data, input.size ) )
+            {
+                decode_partial( d, input.data, input.data + size, output, out );
             }
+            return;
+        }
+
+        if( sparse )
+        {
+            split_zero_runs( input.data, input.data + blocks, decode_part, [ & ]( const std::size_t bytes ){ gap = gap + bytes; } );
+        }
+        else
+        {
+            decode_part( input.data, input.data + blocks );
+        }
+
+        std::memmove( input.data, input.data + blocks, size - blocks );
+        size = size - blocks;
+    }
+
+    close_gap();
+}
+
+
+// A lock-free ring of blocks that passes data from one producer thread to one consumer thread.
+// The producer fills the block returned by 'acquire' and passes it on with 'publish'.
+// The consumer reads the block returned by 'front' and hands it back to the producer with 'release'.
+struct block_ring
+{
+    static constexpr std::size_t slots = 4;
+
+    explicit block_ring( const std::size_t block_size )
+        : blocks( slots * block_size )
+        , block_size( block_size )
+    {}
+
+    // Waits until a block is free.
+    uint8_t * acquire()
+    {
+        const auto h = head.load( std::memory_order_relaxed );
+        while( h - tail.load( std::memory_order_acquire ) == slots )
+        {
+            std::this_thread::yield();
         }
 
-        input  = opts.read_argument();
-        output = opts.read_argument();
+        return block( h );
     }
 
-    if( input.empty() )
+    void publish( const std::size_t size )
     {
-        brle_argument_error( "No input input parameter provided." );
+        const auto h = head.load( std::memory_order_relaxed );
+
+        sizes[ h % slots ] = size;
+        head.store( h + 1, std::memory_order_release );
     }
 
-    if( output.empty() )
+    // Waits until a block is published.
+    const uint8_t * front( std::size_t & size )
     {
-        brle_argument_error( "No output input parameter provided." );
+        const auto t = tail.load( std::memory_order_relaxed );
+        while( head.load( std::memory_order_acquire ) == t )
+        {
+            std::this_thread::yield();
+        }
+
+        size = sizes[ t % slots ];
+
+        return block( t );
     }
 
-    std::FILE * const in_file  = input == "-" ? stdin : std::fopen( std::string( input ).c_str(), "rb" );
-    if( in_file == nullptr )
+    void release()
     {
-        brle_errno( "Input" );
+        tail.store( tail.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
     }
 
-    std::FILE * const out_file = output == "-" ? stdout : std::fopen( std::string( output ).c_str(), "wb" );
-    if( out_file == nullptr )
+    uint8_t * block( const std::size_t index )
     {
-        brle_errno( "Output" );
+        return blocks.data + ( index % slots ) * block_size;
     }
-    
-    if( direction == transformation::encode_ )
+
+    // The size of a published block.
+    std::size_t size( const std::size_t index ) const
+    {
+        return sizes[ index % slots ];
+    }
+
+    // The number of blocks that were published and released since the start.
+    std::size_t published() const
+    {
+        return head.load( std::memory_order_acquire );
+    }
+
+    std::size_t released() const
+    {
+        return tail.load( std::memory_order_acquire );
+    }
+
+    io_buffer                  blocks;
+    const std::size_t          block_size;
+    std::size_t                sizes[ slots ] = {};
+    std::atomic< std::size_t > head        = {};
+    std::atomic< std::size_t > tail        = {};
+};
+
+// Reads the input in whole blocks, a block that is not full is the last one.
+static void read_blocks( std::FILE * const in, block_ring & ring )
+{
+    for( auto size = ring.block_size ; size == ring.block_size ; )
+    {
+        size = read( in, ring.acquire(), ring.block_size );
+        ring.publish( size );
+    }
+}
+
+// Writes blocks until an empty block is received.
+static void write_blocks( block_ring & ring, std::FILE * const out )
+{
+    for( ;; )
     {
-        encode( in_file, out_file );
+        std::size_t size = 0;
+        const auto  data = ring.front( size );
+        if( size == 0 )
+        {
+            return;
+        }
+
+        write( out, data, size );
+        ring.release();
+    }
+}
+
+#if BRLE_HAS_IO_URING
+
+// A minimal io_uring instance on top of the system calls.
+// 'fd' is negative when the kernel does not support io_uring or when it is disabled.
+struct io_ring
+{
+    explicit io_ring( const unsigned entries )
+    {
+        io_uring_params params = {};
+
+        fd = static_cast< int >( syscall( __NR_io_uring_setup, entries, &params ) );
+        if( fd < 0 )
+        {
+            return;
+        }
+
+        const bool single_map = params.features & IORING_FEAT_SINGLE_MMAP;
+
+        sq_map_size = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+        cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+        if( single_map )
+        {
+            sq_map_size = cq_map_size = std::max( sq_map_size, cq_map_size );
+        }
+        sqes_size = params.sq_entries * sizeof( io_uring_sqe );
+
+        sq_map = map( sq_map_size, IORING_OFF_SQ_RING );
+        cq_map = single_map ? sq_map : map( cq_map_size, IORING_OFF_CQ_RING );
+        sqes   = static_cast< io_uring_sqe * >( map( sqes_size, IORING_OFF_SQES ) );
+        if( !sq_map || !cq_map || !sqes )
+        {
+            unmap();
+            return;
+        }
+
+        const auto sq = static_cast< uint8_t * >( sq_map );
+        const auto cq = static_cast< uint8_t * >( cq_map );
+
+        sq_tail = reinterpret_cast< unsigned * >( sq + params.sq_off.tail );
+        sq_mask = *reinterpret_cast< unsigned * >( sq + params.sq_off.ring_mask );
+        cq_head = reinterpret_cast< unsigned * >( cq + params.cq_off.head );
+        cq_tail = reinterpret_cast< unsigned * >( cq + params.cq_off.tail );
+        cq_mask = *reinterpret_cast< unsigned * >( cq + params.cq_off.ring_mask );
+        cqes    = reinterpret_cast< io_uring_cqe * >( cq + params.cq_off.cqes );
+
+        // The submission entries are used in the order of the ring.
+        const auto sq_array = reinterpret_cast< unsigned * >( sq + params.sq_off.array );
+        for( unsigned i = 0 ; i < params.sq_entries ; ++i )
+        {
+            sq_array[ i ] = i;
+        }
+
+        tail = *sq_tail;
+    }
+
+    io_ring( const io_ring & )             = delete;
+    io_ring & operator=( const io_ring & ) = delete;
+
+    ~io_ring()
+    {
+        unmap();
+    }
+
+    // Registers the blocks of a ring as fixed buffers, the index of a buffer equals the index of its slot.
+    bool register_buffers( const uint8_t * const blocks, const std::size_t block_size, const unsigned count )
+    {
+        iovec buffers[ 8 ];
+        for( unsigned i = 0 ; i < count ; ++i )
+        {
+            buffers[ i ] = { const_cast< uint8_t * >( blocks + i * block_size ), block_size };
+        }
+
+        return syscall( __NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers, count ) == 0;
+    }
+
+    // Returns true when the kernel supports the operation 'op'.
+    // Kernels before 5.6 cannot be probed and are treated as not supporting any operation, they lack the plain reads
+    // and writes that are used when the buffers cannot be registered.
+    bool supports( const uint8_t op ) const
+    {
+        constexpr unsigned ops = 256;
+        alignas( io_uring_probe ) uint8_t probe[ sizeof( io_uring_probe ) + ops * sizeof( io_uring_probe_op ) ] = {};
+
+        if( syscall( __NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, ops ) != 0 )
+        {
+            return false;
+        }
+
+        const auto result = reinterpret_cast< const io_uring_probe * >( probe );
+
+        return op <= result->last_op && ( result->ops[ op ].flags & IO_URING_OP_SUPPORTED );
+    }
+
+    // Queues a read or write that is passed to the kernel by the next call of 'submit'.
+    void queue( const uint8_t op, const uint8_t * const data, const std::size_t size, const uint64_t offset,
+                const int buffer_index, const uint64_t user_data )
+    {
+        io_uring_sqe & sqe = sqes[ tail & sq_mask ];
+
+        sqe           = {};
+        sqe.opcode    = op;
+        sqe.fd        = file;
+        sqe.addr      = reinterpret_cast< uint64_t >( data );
+        sqe.len       = static_cast< uint32_t >( size );
+        sqe.off       = offset;
+        sqe.buf_index = static_cast< uint16_t >( buffer_index );
+        sqe.user_data = user_data;
+
+        ++tail;
+        ++queued;
+    }
+
+    // Submits the queued operations in one system call and waits for 'wait' of them to complete.
+    void submit( const unsigned wait )
+    {
+        __atomic_store_n( sq_tail, tail, __ATOMIC_RELEASE );
+
+        while( syscall( __NR_io_uring_enter, fd, queued, wait, wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0 ) < 0 )
+        {
+            if( errno != EINTR )
+            {
+                brle_errno( "io_uring" );
+            }
+        }
+
+        queued = 0;
+    }
+
+    // Takes a completion, returns false when none is available.
+    bool complete( io_uring_cqe & cqe )
+    {
+        const unsigned head = *cq_head;
+        if( head == __atomic_load_n( cq_tail, __ATOMIC_ACQUIRE ) )
+        {
+            return false;
+        }
+
+        cqe = cqes[ head & cq_mask ];
+        __atomic_store_n( cq_head, head + 1, __ATOMIC_RELEASE );
+
+        return true;
+    }
+
+    int fd   = -1;
+    int file = -1;
+
+private:
+    void * map( const std::size_t size, const off_t offset )
+    {
+        void * const address = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset );
+
+        return address != MAP_FAILED ? address : nullptr;
+    }
+
+    void unmap()
+    {
+        if( sqes )
+        {
+            munmap( sqes, sqes_size );
+        }
+        if( cq_map && cq_map != sq_map )
+        {
+            munmap( cq_map, cq_map_size );
+        }
+        if( sq_map )
+        {
+            munmap( sq_map, sq_map_size );
+        }
+        if( fd >= 0 )
+        {
+            close( fd );
+        }
+
+        sqes   = nullptr;
+        sq_map = cq_map = nullptr;
+        fd     = -1;
+    }
+
+    void *         sq_map      = nullptr;
+    void *         cq_map      = nullptr;
+    io_uring_sqe * sqes        = nullptr;
+    io_uring_cqe * cqes        = nullptr;
+    std::size_t    sq_map_size = 0;
+    std::size_t    cq_map_size = 0;
+    std::size_t    sqes_size   = 0;
+    unsigned *     sq_tail     = nullptr;
+    unsigned *     cq_head     = nullptr;
+    unsigned *     cq_tail     = nullptr;
+    unsigned       sq_mask     = 0;
+    unsigned       cq_mask     = 0;
+    unsigned       tail        = 0;
+    unsigned       queued      = 0;
+};
+
+static void io_ring_error( const int result, const char * const prefix )
+{
+    errno = result < 0 ? -result : EIO;
+    brle_errno( prefix );
+}
+
+// Reads a regular file from offset 'start' with a read queued ahead of the codec for every free block of the ring.
+// The offset of the file is moved to its end afterwards, like reading it with stdio does.
+static void read_blocks_async( io_ring & uring, const off_t start, const std::size_t file_size, block_ring & ring )
+{
+    const auto  size   = file_size > static_cast< std::size_t >( start ) ? file_size - static_cast< std::size_t >( start ) : 0;
+    const bool  fixed  = uring.register_buffers( ring.blocks.data, ring.block_size, block_ring::slots );
+    const auto  op     = static_cast< uint8_t >( fixed ? IORING_OP_READ_FIXED : IORING_OP_READ );
+    const auto  blocks = size / ring.block_size + 1;    // The last block is not full, it may be empty.
+
+    std::size_t filled[ block_ring::slots ] = {};
+    std::size_t queued                      = 0;
+    unsigned    in_flight                   = 0;
+
+    const auto expected = [ & ]( const std::size_t index )
+    {
+        return std::min( ring.block_size, size - index * ring.block_size );
+    };
+
+    const auto read_block = [ & ]( const std::size_t index )
+    {
+        const auto slot = index % block_ring::slots;
+
+        uring.queue( op, ring.block( index ) + filled[ slot ], expected( index ) - filled[ slot ],
+                     static_cast< uint64_t >( start ) + index * ring.block_size + filled[ slot ], static_cast< int >( slot ), index );
+        ++in_flight;
+    };
+
+    for( std::size_t published = 0 ; published < blocks ; )
+    {
+        for( ; queued < blocks && queued - ring.released() < block_ring::slots ; ++queued )
+        {
+            filled[ queued % block_ring::slots ] = 0;
+            if( expected( queued ) > 0 )
+            {
+                read_block( queued );
+            }
+        }
+
+        for( ; published < queued && filled[ published % block_ring::slots ] == expected( published ) ; ++published )
+        {
+            ring.publish( expected( published ) );
+        }
+
+        if( in_flight == 0 )
+        {
+            std::this_thread::yield();    // Waiting for the codec to release blocks
+            continue;
+        }
+
+        uring.submit( 1 );
+
+        for( io_uring_cqe cqe ; uring.complete( cqe ) ; )
+        {
+            --in_flight;
+            if( cqe.res <= 0 )
+            {
+                io_ring_error( cqe.res, "Input" );
+            }
+
+            filled[ cqe.user_data % block_ring::slots ] += static_cast< std::size_t >( cqe.res );
+            if( filled[ cqe.user_data % block_ring::slots ] < expected( cqe.user_data ) )
+            {
+                read_block( cqe.user_data );    // Continue a short read
+            }
+        }
+    }
+
+    if( lseek( uring.file, start + static_cast< off_t >( size ), SEEK_SET ) < 0 )
+    {
+        brle_errno( "Input" );
+    }
+}
+
+// Writes blocks to a regular file from offset 'start' with a write in flight for every published block until an empty block
+// is received. The offset of the file is moved to the end of the written data afterwards, like writing it with stdio does.
+static void write_blocks_async( io_ring & uring, const off_t start, block_ring & ring )
+{
+    const bool fixed = uring.register_buffers( ring.blocks.data, ring.block_size, block_ring::slots );
+    const auto op    = static_cast< uint8_t >( fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE );
+
+    uint64_t    offsets[ block_ring::slots ] = {};
+    std::size_t written[ block_ring::slots ] = {};
+    std::size_t queued                       = 0;
+    std::size_t released                     = 0;
+    uint64_t    offset                       = static_cast< uint64_t >( start );
+    unsigned    in_flight                    = 0;
+    bool        end_of_output                = false;
+
+    const auto write_block = [ & ]( const std::size_t index )
+    {
+        const auto slot = index % block_ring::slots;
+
+        uring.queue( op, ring.block( index ) + written[ slot ], ring.size( index ) - written[ slot ],
+                     offsets[ slot ] + written[ slot ], static_cast< int >( slot ), index );
+        ++in_flight;
+    };
+
+    for( ;; )
+    {
+        for( const auto published = ring.published() ; !end_of_output && queued < published ; ++queued )
+        {
+            const auto slot = queued % block_ring::slots;
+
+            end_of_output = ring.size( queued ) == 0;
+            if( end_of_output )
+            {
+                break;
+            }
+
+            offsets[ slot ] = offset;
+            written[ slot ] = 0;
+            offset          = offset + ring.size( queued );
+            write_block( queued );
+        }
+
+        for( ; released < queued && written[ released % block_ring::slots ] == ring.size( released ) ; ++released )
+        {
+            ring.release();
+        }
+
+        if( in_flight == 0 )
+        {
+            if( end_of_output )
+            {
+                if( lseek( uring.file, static_cast< off_t >( offset ), SEEK_SET ) < 0 )
+                {
+                    brle_errno( "Output" );
+                }
+                return;
+            }
+
+            std::this_thread::yield();    // Waiting for the codec to publish blocks
+            continue;
+        }
+
+        uring.submit( 1 );
+
+        for( io_uring_cqe cqe ; uring.complete( cqe ) ; )
+        {
+            --in_flight;
+            if( cqe.res <= 0 )
+            {
+                io_ring_error( cqe.res, "Output" );
+            }
+
+            written[ cqe.user_data % block_ring::slots ] += static_cast< std::size_t >( cqe.res );
+            if( written[ cqe.user_data % block_ring::slots ] < ring.size( cqe.user_data ) )
+            {
+                write_block( cqe.user_data );    // Continue a short write
+            }
+        }
+    }
+}
+
+#endif
+
+// Starts the thread that reads the input into the ring.
+// Regular files are read with io_uring from their current offset when 'async_io' is set and the kernel supports
+// reads with io_uring.
+static std::thread start_reader( std::FILE * const in, block_ring & ring, const bool async_io )
+{
+    return std::thread( [ =, &ring ]()
+    {
+        try
+        {
+#if BRLE_HAS_IO_URING
+            std::size_t file_size = 0;
+            const off_t start     = async_io && is_regular_file( in, file_size ) ? lseek( fileno( in ), 0, SEEK_CUR ) : -1;
+            if( start >= 0 )
+            {
+                io_ring uring( 2 * block_ring::slots );
+                if( uring.fd >= 0 && uring.supports( IORING_OP_READ ) )
+                {
+                    uring.file = fileno( in );
+                    read_blocks_async( uring, start, file_size, ring );
+                    return;
+                }
+            }
+#else
+            static_cast< void >( async_io );
+#endif
+            read_blocks( in, ring );
+        }
+        catch( const io_error & error )
+        {
+            exit_on_error( error );
+        }
+    } );
+}
+
+// Starts the thread that writes the blocks of the ring to the output.
+// Regular files that do not append are written with io_uring from their current offset when 'async_io' is set and
+// the kernel supports writes with io_uring.
+static std::thread start_writer( block_ring & ring, std::FILE * const out, const bool async_io )
+{
+    return std::thread( [ =, &ring ]()
+    {
+        try
+        {
+#if BRLE_HAS_IO_URING
+            std::size_t file_size = 0;
+            const off_t start     = async_io && is_regular_file( out, file_size ) && !is_appending( out ) ? lseek( fileno( out ), 0, SEEK_CUR ) : -1;
+            if( start >= 0 )
+            {
+                io_ring uring( 2 * block_ring::slots );
+                if( uring.fd >= 0 && uring.supports( IORING_OP_WRITE ) )
+                {
+                    uring.file = fileno( out );
+                    write_blocks_async( uring, start, ring );
+                    return;
+                }
+            }
+#else
+            static_cast< void >( async_io );
+#endif
+            write_blocks( ring, out );
+        }
+        catch( const io_error & error )
+        {
+            exit_on_error( error );
+        }
+    } );
+}
+
+// Passes the blocks of the codec to the writer thread.
+struct ring_output
+{
+    explicit ring_output( block_ring & ring )
+        : ring( ring )
+        , first( ring.acquire() )
+    {}
+
+    uint8_t * last() const
+    {
+        return first + ring.block_size;
+    }
+
+    // Passes the data up to 'end' and continues in a new block.
+    uint8_t * commit( uint8_t * const end )
+    {
+        if( end != first )
+        {
+            ring.publish( static_cast< std::size_t >( end - first ) );
+            first = ring.acquire();
+        }
+
+        return first;
+    }
+
+    // Passes an empty block that ends the output.
+    void close( uint8_t * const end )
+    {
+        commit( end );
+        ring.publish( 0 );
+    }
+
+    block_ring & ring;
+    uint8_t *    first;
+};
+
+// Reads the blocks of the reader thread like read() from a file.
+struct ring_input
+{
+    explicit ring_input( block_ring & ring )
+        : ring( ring )
+    {}
+
+    std::size_t read( uint8_t * const data, const std::size_t size )
+    {
+        std::size_t n = 0;
+        while( n < size && !end_of_input )
+        {
+            if( block == nullptr )
+            {
+                block  = ring.front( block_size );
+                offset = 0;
+            }
+
+            const auto count = std::min( size - n, block_size - offset );
+            std::memcpy( data + n, block + offset, count );
+            n      = n + count;
+            offset = offset + count;
+
+            if( offset == block_size )
+            {
+                end_of_input = block_size < ring.block_size;
+                block        = nullptr;
+                ring.release();
+            }
+        }
+
+        return n;
+    }
+
+    block_ring &    ring;
+    const uint8_t * block        = nullptr;
+    std::size_t     block_size   = 0;
+    std::size_t     offset       = 0;
+    bool            end_of_input = false;
+};
+
+// Encodes on the calling thread while the input is read and the output is written by two other threads.
+static void encode_pipelined( std::FILE * const in, std::FILE * const out, const bool async_io )
+{
+    block_ring input_ring( buffer_size );
+    block_ring output_ring( buffer_size );
+
+    std::thread reader = start_reader( in, input_ring, async_io );
+    std::thread writer = start_writer( output_ring, out, async_io );
+
+    ring_output output( output_ring );
+
+    pg::brle::encoder< uint8_t, pg::brle::brle8 * > e( output.first );
+
+    for( auto size = input_ring.block_size ; size == input_ring.block_size ; input_ring.release() )
+    {
+        const auto data = input_ring.front( size );
+        for( auto first = data, last = data + size ; first != last ; )
+        {
+            first = pg::brle::encode_some( e, first, last, output.last() );
+            e.set_output( output.commit( e.get_output() ) );
+        }
+    }
+
+    output.close( e.flush() );
+
+    reader.join();
+    writer.join();
+}
+
+// Decodes on the calling thread while the input is read and the output is written by two other threads.
+static void decode_pipelined( std::FILE * const in, std::FILE * const out, const bool async_io )
+{
+    block_ring input_ring( buffer_size );
+    block_ring output_ring( buffer_size * 9 );    // A block decodes to at most 71 bits.
+
+    std::thread reader = start_reader( in, input_ring, async_io );
+    std::thread writer = start_writer( output_ring, out, async_io );
+
+    ring_input  source( input_ring );
+    ring_output output( output_ring );
+    io_buffer   input( buffer_size );
+
+    std::size_t size = 0;
+    for( bool end_of_input = false ; !end_of_input ; )
+    {
+        size         = size + source.read( input.data + size, input.size - size );
+        end_of_input = size < input.size;
+
+        // The blocks that do not complete a byte are kept for the next read.
+        const auto blocks = end_of_input ? size : byte_aligned_blocks( input.data, input.data + size );
+        if( blocks == 0 && !end_of_input )
+        {
+            pg::brle::decoder< uint8_t, const pg::brle::brle8 * > d;
+            for( ; size > 0 ; size = source.read( input.data, input.size ) )
+            {
+                d.set_input( input.data, input.data + size );
+                for( auto end = pg::brle::decode_some( d, output.first, output.last() ) ; end != output.first ;
+                          end = pg::brle::decode_some( d, output.first, output.last() ) )
+                {
+                    output.commit( end );
+                }
+            }
+            break;
+        }
+
+        output.commit( pg::brle::decode( input.data, input.data + blocks, output.first ) );
+
+        std::memmove( input.data, input.data + blocks, size - blocks );
+        size = size - blocks;
+    }
+
+    output.close( output.first );
+
+    reader.join();
+    writer.join();
+}
+
+// An input and output file of a batch.
+struct batch_job
+{
+    std::string input;
+    std::string output;
+};
+
+// The output of an input without an explicit output in a batch.
+// When encoding 'file' becomes 'file.rle', when decoding 'file.rle' becomes 'file' and other names get the '.out' extension.
+static std::string output_name( const std::string_view input, const bool encoding )
+{
+    constexpr std::string_view extension = ".rle";
+
+    if( encoding )
+    {
+        return std::string( input ) + std::string( extension );
+    }
+
+    if( input.size() > extension.size() && input.substr( input.size() - extension.size() ) == extension )
+    {
+        return std::string( input.substr( 0, input.size() - extension.size() ) );
+    }
+
+    return std::string( input ) + ".out";
+}
+
+// Reads the jobs from a list with one input per line, optionally followed by a tab and the output.
+static void read_list( const std::string_view path, const bool encoding, std::vector< batch_job > & jobs )
+{
+    std::FILE * const list = path == "-" ? stdin : std::fopen( std::string( path ).c_str(), "rb" );
+    if( list == nullptr )
+    {
+        brle_errno( "List" );
+    }
+
+    std::string line;
+    for( int c = std::fgetc( list ) ; c != EOF || !line.empty() ; c = std::fgetc( list ) )
+    {
+        if( c != '\n' && c != EOF )
+        {
+            line.push_back( static_cast< char >( c ) );
+            continue;
+        }
+
+        if( !line.empty() && line.back() == '\r' )
+        {
+            line.pop_back();
+        }
+
+        const auto tab = line.find( '\t' );
+        if( tab != std::string::npos )
+        {
+            jobs.push_back( { line.substr( 0, tab ), line.substr( tab + 1 ) } );
+        }
+        else if( !line.empty() )
+        {
+            jobs.push_back( { line, output_name( line, encoding ) } );
+        }
+
+        line.clear();
+        if( c == EOF )
+        {
+            break;
+        }
+    }
+
+    if( std::ferror( list ) )
+    {
+        brle_errno( "List" );
+    }
+
+    if( list != stdin )
+    {
+        std::fclose( list );
+    }
+}
+
+// Encodes or decodes the files of a job.
+// Returns false when the job failed, the error is written to the standard error with the name of the input.
+static bool run_job( const batch_job & job, const bool encoding, codec_buffers & buffers )
+{
+    std::FILE * in  = nullptr;
+    std::FILE * out = nullptr;
+    bool        ok  = true;
+
+    try
+    {
+        in = std::fopen( job.input.c_str(), "rb" );
+        if( in == nullptr )
+        {
+            brle_errno( "Input" );
+        }
+
+        out = std::fopen( job.output.c_str(), "w+b" );
+        if( out == nullptr )
+        {
+            brle_errno( "Output" );
+        }
+
+        encoding ? encode( in, out, buffers, true ) : decode( in, out, buffers, true, true );
+
+        const bool closed = std::fclose( out ) == 0;
+        out = nullptr;
+        if( !closed )
+        {
+            brle_errno( "Output" );
+        }
+    }
+    catch( const io_error & error )
+    {
+        std::fprintf( stderr, "%s: %s: %s\n", job.input.c_str(), error.prefix, std::strerror( error.error ) );
+        ok = false;
+    }
+
+    if( in )
+    {
+        std::fclose( in );
+    }
+    if( out )
+    {
+        std::fclose( out );
+    }
+
+    return ok;
+}
+
+// Runs the jobs on a pool of threads that take the next job from a shared index when they are done with the previous one.
+// Each thread reuses its buffers for all of its jobs. Returns the number of failed jobs.
+static std::size_t run_batch( const std::vector< batch_job > & jobs, const bool encoding, const unsigned threads )
+{
+    std::atomic< std::size_t > next     = {};
+    std::atomic< std::size_t > failures = {};
+
+    const auto worker = [ & ]()
+    {
+        codec_buffers buffers;
+        for( auto i = next++ ; i < jobs.size() ; i = next++ )
+        {
+            if( !run_job( jobs[ i ], encoding, buffers ) )
+            {
+                ++failures;
+            }
+        }
+    };
+
+    std::vector< std::thread > pool;
+    for( unsigned i = 1 ; i < std::min< std::size_t >( threads, jobs.size() ) ; ++i )
+    {
+        pool.emplace_back( worker );
+    }
+
+    worker();
+
+    for( auto & thread : pool )
+    {
+        thread.join();
+    }
+
+    return failures;
+}
+
+// The statistics of the run times of a benchmark in milliseconds.
+struct timings
+{
+    double min;
+    double median;
+    double p99;
+};
+
+template< typename Function >
+static timings measure( const unsigned iterations, Function f )
+{
+    std::vector< double > times;
+    for( unsigned i = 0 ; i < iterations ; ++i )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto stop  = std::chrono::steady_clock::now();
+
+        times.push_back( std::chrono::duration< double, std::milli >( stop - start ).count() );
+    }
+
+    std::sort( times.begin(), times.end() );
+
+    return { times.front(), times[ times.size() / 2 ], times[ ( times.size() * 99 + 99 ) / 100 - 1 ] };
+}
+
+static void print_timings( const char * const direction, const std::size_t bytes, const timings & t )
+{
+    std::printf( "  %s %10.1f MB/s  min %9.3f ms  median %9.3f ms  p99 %9.3f ms\n",
+                 direction, static_cast< double >( bytes ) / ( t.median * 1000.0 ), t.min, t.median, t.p99 );
+}
+
+// Times the encoding and decoding of the data as values of DataT, a remainder that does not fill a whole value is left out.
+// The data is encoded and decoded once before the measurements to verify the round trip and to touch all the buffers.
+template< typename DataT >
+static void benchmark( const char * const type, const std::vector< uint8_t > & data, const unsigned iterations )
+{
+    const auto count = data.size() / sizeof( DataT );
+    const auto bytes = count * sizeof( DataT );
+    if( count == 0 )
+    {
+        std::printf( "%s: input is smaller than one value\n", type );
+        return;
+    }
+
+    std::vector< DataT > input( count );
+    std::vector< DataT > output( count );
+    std::memcpy( input.data(), data.data(), bytes );
+
+    const auto first = input.data();
+    const auto last  = first + count;
+
+    std::vector< pg::brle::brle8 > rle( pg::brle::encoded_size( first, last ) );
+
+    const auto rle_last = pg::brle::encode( first, last, rle.data() );
+    pg::brle::decode( rle.data(), rle_last, output.data() );
+    if( output != input )
+    {
+        std::printf( "%s: decoded data differs from the input\n", type );
+        return;
+    }
+
+    const auto encoding = measure( iterations, [ & ](){ pg::brle::encode( first, last, rle.data() ); } );
+    const auto decoding = measure( iterations, [ & ](){ pg::brle::decode( rle.data(), rle_last, output.data() ); } );
+
+    std::printf( "%s: %zu bytes, %zu RLE bytes, ratio %.2f\n", type, bytes, rle.size(),
+                 static_cast< double >( bytes ) / static_cast< double >( std::max< std::size_t >( rle.size(), 1 ) ) );
+    print_timings( "encode", bytes, encoding );
+    print_timings( "decode", bytes, decoding );
+}
+
+static std::vector< uint8_t > read_all( std::FILE * const in )
+{
+    std::vector< uint8_t > data;
+    io_buffer              buffer( buffer_size );
+
+    for( auto size = read( in, buffer.data, buffer.size ) ; size > 0 ; size = read( in, buffer.data, buffer.size ) )
+    {
+        data.insert( data.end(), buffer.data, buffer.data + size );
+    }
+
+    return data;
+}
+
+
+int main( const int argc, const char * argv[] )
+{
+    enum transformation : char { encode_ = 'e', decode_ = 'd', benchmark_ = 'b' };
+
+    transformation   direction  = transformation::encode_;
+    bool             pipelined  = false;
+    bool             async_io   = false;
+    unsigned         threads    = 0;
+    unsigned         iterations = 20;
+    bool             sweep      = false;
+    std::string_view list;
+
+    std::vector< std::string_view > operands;
+
+    {
+        options opts( argc, argv );
+        for( char opt = opts.read_option() ; opt != '\0' ; opt = opts.read_option() )
+        {
+            switch( opt )
+            {
+            case 'e':
+                direction = transformation::encode_;
+                break;
+                
+            case 'd':
+                direction = transformation::decode_;
+                break;
+
+            case 'b':
+                direction = transformation::benchmark_;
+                break;
+
+            case 'n':
+            {
+                const auto count = opts.read_argument();
+                iterations = static_cast< unsigned >( std::strtoul( std::string( count ).c_str(), nullptr, 10 ) );
+                if( iterations == 0 )
+                {
+                    brle_argument_error( "Invalid number of iterations '%s'.", std::string( count ).c_str() );
+                }
+                break;
+            }
+
+            case 's':
+                sweep = true;
+                break;
+
+            case 'p':
+                pipelined = true;
+                break;
+
+            case 'u':
+                pipelined = true;
+                async_io  = true;
+                break;
+
+            case 'j':
+            {
+                const auto count = opts.read_argument();
+                threads = static_cast< unsigned >( std::strtoul( std::string( count ).c_str(), nullptr, 10 ) );
+                if( threads == 0 )
+                {
+                    brle_argument_error( "Invalid number of threads '%s'.", std::string( count ).c_str() );
+                }
+                break;
+            }
+
+            case 'l':
+                list = opts.read_argument();
+                if( list.empty() )
+                {
+                    brle_argument_error( "No list provided." );
+                }
+                break;
+
+            case 'h':
+                print_help();
+                break;
+
+            default:
+                brle_argument_error( "Unrecognized option '%c'.", opt );
+            }
+        }
+
+        for( auto operand = opts.read_argument() ; !operand.empty() ; operand = opts.read_argument() )
+        {
+            operands.push_back( operand );
+        }
+    }
+
+    const bool encoding = direction == transformation::encode_;
+
+    try
+    {
+        if( direction == transformation::benchmark_ )
+        {
+            if( operands.empty() )
+            {
+                brle_argument_error( "No input input parameter provided." );
+            }
+
+            std::FILE * const in_file = operands[ 0 ] == "-" ? stdin : std::fopen( std::string( operands[ 0 ] ).c_str(), "rb" );
+            if( in_file == nullptr )
+            {
+                brle_errno( "Input" );
+            }
+
+            const auto data = read_all( in_file );
+            if( in_file != stdin )
+            {
+                std::fclose( in_file );
+            }
+
+            benchmark< uint8_t >( "uint8_t", data, iterations );
+            if( sweep )
+            {
+                benchmark< uint16_t >( "uint16_t", data, iterations );
+                benchmark< uint32_t >( "uint32_t", data, iterations );
+                benchmark< uint64_t >( "uint64_t", data, iterations );
+            }
+
+            return 0;
+        }
+
+        if( threads > 0 || !list.empty() )
+        {
+            std::vector< batch_job > jobs;
+            for( const auto operand : operands )
+            {
+                jobs.push_back( { std::string( operand ), output_name( operand, encoding ) } );
+            }
+
+            if( !list.empty() )
+            {
+                read_list( list, encoding, jobs );
+            }
+
+            if( jobs.empty() )
+            {
+                brle_argument_error( "No input files provided." );
+            }
+
+            return run_batch( jobs, encoding, threads > 0 ? threads : 1u ) == 0 ? 0 : EXIT_FAILURE;
+        }
+
+        if( operands.size() < 1 )
+        {
+            brle_argument_error( "No input input parameter provided." );
+        }
+
+        if( operands.size() < 2 )
+        {
+            brle_argument_error( "No output input parameter provided." );
+        }
+
+        const auto input  = operands[ 0 ];
+        const auto output = operands[ 1 ];
+
+        std::FILE * const in_file  = input == "-" ? stdin : std::fopen( std::string( input ).c_str(), "rb" );
+        if( in_file == nullptr )
+        {
+            brle_errno( "Input" );
+        }
+
+        std::FILE * const out_file = output == "-" ? stdout : std::fopen( std::string( output ).c_str(), "w+b" );
+        if( out_file == nullptr )
+        {
+            brle_errno( "Output" );
+        }
+
+        if( pipelined )
+        {
+            encoding ? encode_pipelined( in_file, out_file, async_io ) : decode_pipelined( in_file, out_file, async_io );
+        }
+        else
+        {
+            codec_buffers buffers;
+            const bool named_input  = input != "-";
+            const bool named_output = output != "-";
+
+            encoding ? encode( in_file, out_file, buffers, named_input ) : decode( in_file, out_file, buffers, named_input, named_output );
+        }
+
+        // Errors of the data that stdio still buffers are only reported when it is flushed.
+        if( ( out_file == stdout ? std::fflush( out_file ) : std::fclose( out_file ) ) != 0 )
+        {
+            brle_errno( "Output" );
+        }
     }
-    else
+    catch( const io_error & error )
     {
-        decode( in_file, out_file );
+        exit_on_error( error );
     }
 
     return 0;